@@ -0,0 +1,226 @@
+// Standard C++
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Macros and headers for boost
+#include "boost_definitions.h"
+
+// Support classes
+#include "Log.h"
+#include "Profiler.h"
+#include "Solver.h"
+
+// Namespaces
+using namespace std;
+
+//
+// Benchmark: every method over the instances of the data directories (the
+// instance_*_<method>.json files) and over instance files given as is, for
+// example generated large ones. Each run reports its wall time, CPU time
+// and peak RSS, per phase (load, CDT build, search, export) and for the hot
+// primitives, and its event counters (POLYG_STATS), in a JSON file for
+// comparisons between releases.
+//
+// polyg_bench [--methods legacy,local,sa,ant] [--repeat n] [--output bench.json] [--verbose] directory|instance.json ...
+//
+
+struct BenchRun {
+    string input;
+    string method;
+    int repeat = 0;
+    SolveReport report;
+    double wall_seconds = 0;
+    double cpu_seconds = 0;
+    long peak_rss_kb = 0;
+};
+
+vector<string> split(const string& list, char separator) {
+    vector<string> items;
+    std::istringstream fields(list);
+    string item;
+
+    while (std::getline(fields, item, separator)) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+
+    return items;
+}
+
+// Instances of a directory for a method: instance_<name>_<method>.json
+vector<string> instancesOf(const std::filesystem::path& directory, const string& method) {
+    vector<string> inputs;
+    string suffix = "_" + method + ".json";
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        string name = entry.path().filename().string();
+
+        if (entry.is_regular_file() && name.compare(0, 9, "instance_") == 0 && name.size() > suffix.size() &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            inputs.push_back(entry.path().string());
+        }
+    }
+
+    std::sort(inputs.begin(), inputs.end());
+
+    return inputs;
+}
+
+BenchRun runOnce(const string& input, const std::filesystem::path& outputdir, int repeat, bool verbose) {
+    BenchRun run;
+
+    run.input = input;
+    run.repeat = repeat;
+    run.report.input = input;
+    run.report.output = (outputdir / std::filesystem::path(input).filename()).string();
+
+    // Same random choices in every run of an instance
+    run.report.seed = 1;
+    run.report.fixed_seed = true;
+
+    // Only the errors of the runs, unless verbose
+    logging::Level level = logging::level();
+
+    if (!verbose) {
+        logging::setLevel(logging::ERROR);
+    }
+
+    profiler::reset();
+
+    auto start = std::chrono::steady_clock::now();
+    double cpu_start = profiler::cpuSeconds();
+
+    try {
+        CDT cdt;
+
+        if (solve(run.report.input.c_str(), run.report.output.c_str(), run.report, cdt) != 0) {
+            run.report.status = "failed";
+        }
+    } catch (const std::exception& e) {
+        POLYG_LOG(ERROR, "Instance " << input << ": " << e.what());
+        run.report.status = "error";
+    }
+
+    run.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.cpu_seconds = profiler::cpuSeconds() - cpu_start;
+    run.peak_rss_kb = profiler::peakRssKb();
+    run.method = run.report.method;
+
+    logging::flush();
+    logging::setLevel(level);
+
+    return run;
+}
+
+boost::property_tree::ptree toTree(const BenchRun& run) {
+    boost::property_tree::ptree pt_run = statsTree(run.report);
+
+    pt_run.put("repeat", run.repeat);
+    pt_run.put("status", run.report.status);
+    pt_run.put("wall_seconds", run.wall_seconds);
+    pt_run.put("cpu_seconds", run.cpu_seconds);
+    pt_run.put("peak_rss_kb", run.peak_rss_kb);
+
+    boost::property_tree::ptree pt_primitives;
+
+    for (int i = 0; i < profiler::PRIMITIVES; i++) {
+        const profiler::PrimitiveTimes& t = profiler::primitives[i];
+        boost::property_tree::ptree pt_primitive;
+
+        pt_primitive.put("calls", t.calls.load());
+        pt_primitive.put("seconds", t.nanoseconds.load() * 1e-9);
+
+        pt_primitives.add_child(profiler::primitiveName((profiler::Primitive)i), pt_primitive);
+    }
+
+    pt_run.add_child("primitives", pt_primitives);
+
+    return pt_run;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> methods = {"legacy", "local", "sa", "ant"};
+    vector<string> sources;
+    string outputfile = "bench.json";
+    int repeats = 1;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "--methods" && i + 1 < argc) {
+            methods = split(argv[++i], ',');
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeats = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputfile = argv[++i];
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            cout << "Invalid arguments: syntax: ./polyg_bench [--methods legacy,local,sa,ant] [--repeat n] [--output bench.json] [--verbose] directory|instance.json ..." << endl;
+            return 1;
+        } else {
+            sources.push_back(arg);
+        }
+    }
+
+    if (sources.empty()) {
+        sources.push_back("../data");
+    }
+
+    vector<string> inputs;
+
+    for (const string& source : sources) {
+        if (std::filesystem::is_directory(source)) {
+            for (const string& method : methods) {
+                vector<string> found = instancesOf(source, method);
+                inputs.insert(inputs.end(), found.begin(), found.end());
+            }
+        } else {
+            inputs.push_back(source); // the method of the file
+        }
+    }
+
+    std::filesystem::path outputdir = std::filesystem::temp_directory_path() / "polyg_bench";
+    std::filesystem::create_directories(outputdir);
+
+    cout << "Benchmark: " << inputs.size() << " instances, " << repeats << " runs each" << endl;
+
+    profiler::enabled = true;
+
+    boost::property_tree::ptree pt_runs;
+
+    for (const string& input : inputs) {
+        for (int r = 0; r < repeats; r++) {
+            BenchRun run = runOnce(input, outputdir, r, verbose);
+
+            cout << run.input << " [" << run.method << "] " << run.report.status << ": " << run.wall_seconds << " s wall, " << run.cpu_seconds << " s cpu, "
+                 << run.peak_rss_kb << " KB peak" << endl;
+
+            pt_runs.push_back(std::make_pair("", toTree(run)));
+        }
+    }
+
+    boost::property_tree::ptree pt_root;
+
+    pt_root.put("cgal_version", CGAL_VERSION_STR);
+    pt_root.put("timestamp", (long)time(nullptr));
+    pt_root.put("runs_total", pt_runs.size());
+    pt_root.add_child("runs", pt_runs);
+
+    cout << "Saving benchmark ... " << outputfile << endl;
+    boost::property_tree::write_json(outputfile, pt_root);
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+// Standard C++
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Support classes
+#include "BinaryFormat.h"
+#include "JsonCursor.h"
+#include "JsonExporter.h"
+#include "JsonLoader.h"
+#include "Log.h"
+#include "utils.hpp"
+
+// Namespaces
+using namespace std;
+
+//
+// Converter between the CG:SHOP JSON and the binary format (BinaryFormat.h),
+// both ways, for instances and solutions: a binary input is written as
+// JSON, a JSON input as binary. Coordinates stay exact. Plain CG:SHOP
+// instances, without method or parameters, are written with an empty method.
+//
+// polyg_convert input output
+//
+
+string readFile(const char* path) {
+    ifstream in(path, ios::binary);
+
+    if (!in) {
+        throw runtime_error(string("cannot open ") + path);
+    }
+
+    string text;
+
+    in.seekg(0, ios::end);
+    text.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0, ios::beg);
+    in.read(&text[0], text.size());
+
+    return text;
+}
+
+// Integers as numbers, other coordinates as "p/q" strings
+void appendCoordinate(string& out, const K::FT& coord) {
+    string rational;
+
+    utils::append_rational(rational, coord);
+
+    if (rational.size() > 2 && rational.compare(rational.size() - 2, 2, "/1") == 0) {
+        out.append(rational, 0, rational.size() - 2);
+    } else {
+        out += '"';
+        out += rational;
+        out += '"';
+    }
+}
+
+void writeInstanceJson(const char* outputfile, const JsonLoader& loader) {
+    const vector<Point>& points = loader.getPoints();
+    char number[32];
+    string text;
+
+    text += "{\n    \"instance_uid\": \"" + loader.getInstance() + "\",\n";
+
+    // Plain CG:SHOP instances have neither method nor parameters
+    if (!loader.getMethod().empty()) {
+        text += "    \"method\": \"" + loader.getMethod() + "\",\n";
+    }
+
+    text += "    \"num_points\": " + std::to_string(points.size()) + ",\n";
+
+    for (int axis = 0; axis < 2; axis++) {
+        text += axis == 0 ? "    \"points_x\": [" : "],\n    \"points_y\": [";
+
+        for (size_t i = 0; i < points.size(); i++) {
+            text += i > 0 ? ", " : "";
+            appendCoordinate(text, axis == 0 ? points[i].x() : points[i].y());
+        }
+    }
+
+    text += "],\n    \"region_boundary\": [";
+
+    const vector<int>& boundary = loader.getRegionBoundaries();
+
+    for (size_t i = 0; i < boundary.size(); i++) {
+        text += i > 0 ? ", " : "";
+        text += std::to_string(boundary[i]);
+    }
+
+    const vector<std::pair<int, int>>& constraints = loader.getConstraints();
+
+    text += "],\n    \"num_constraints\": " + std::to_string(constraints.size()) + ",\n    \"additional_constraints\": [";
+
+    for (size_t i = 0; i < constraints.size(); i++) {
+        text += i > 0 ? ", [" : "[";
+        text += std::to_string(constraints[i].first) + ", " + std::to_string(constraints[i].second) + "]";
+    }
+
+    text += "]";
+
+    if (!loader.getParameters().empty()) {
+        text += ",\n    \"parameters\": {";
+
+        bool first = true;
+
+        for (const auto& parameter : loader.getParameters()) {
+            snprintf(number, sizeof(number), "%.17g", parameter.second);
+            text += first ? "\n        \"" : ",\n        \"";
+            text += parameter.first + "\": " + number;
+            first = false;
+        }
+
+        text += "\n    }";
+    }
+
+    text += "\n}\n";
+
+    ofstream file(outputfile, ios::binary | ios::trunc);
+    file.write(text.data(), text.size());
+    file.close();
+
+    if (!file) {
+        throw runtime_error(string("cannot write ") + outputfile);
+    }
+}
+
+// Steiner points and edges of a CG:SHOP solution
+void readSolutionJson(const string& text, JsonExporter& solution) {
+    JsonCursor cursor(text.data(), text.data() + text.size());
+    vector<K::FT> coordinates[2];
+
+    cursor.expect('{');
+
+    if (!cursor.consume('}')) {
+        do {
+            string key = cursor.parseString();
+            cursor.expect(':');
+
+            if (key == "content_type") {
+                solution.content_type = cursor.parseString();
+            } else if (key == "instance_uid") {
+                solution.instance_uid = cursor.parseString();
+            } else if (key == "steiner_points_x" || key == "steiner_points_y") {
+                vector<K::FT>& axis = coordinates[key == "steiner_points_x" ? 0 : 1];
+
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        axis.push_back(cursor.parseCoordinate());
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            } else if (key == "edges") {
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        cursor.expect('[');
+                        int first = int(cursor.parseInteger());
+                        cursor.expect(',');
+                        int second = int(cursor.parseInteger());
+                        cursor.expect(']');
+                        solution.edges.emplace_back(first, second);
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            } else {
+                cursor.skipValue();
+            }
+        } while (cursor.consume(','));
+        cursor.expect('}');
+    }
+
+    if (coordinates[0].size() != coordinates[1].size()) {
+        cursor.fail("steiner_points_x and steiner_points_y differ in length");
+    }
+
+    for (size_t i = 0; i < coordinates[0].size(); i++) {
+        solution.steiner_points.emplace_back(coordinates[0][i], coordinates[1][i]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cout << "Invalid arguments: syntax: ./polyg_convert input.json output.bin" << endl;
+        cout << "                       or: ./polyg_convert input.bin output.json" << endl;
+        return 0;
+    }
+
+    const char* inputfile = argv[1];
+    const char* outputfile = argv[2];
+
+    try {
+        if (BinaryFile::isBinary(inputfile)) {
+            BinaryFile file(inputfile);
+
+            if (file.header().kind == BinaryFile::INSTANCE) {
+                JsonLoader loader;
+
+                loader.load(inputfile, true);
+                writeInstanceJson(outputfile, loader);
+            } else {
+                JsonExporter solution(file.instanceUid());
+
+                solution.content_type = file.label();
+
+                for (size_t i = 0; i < file.header().num_points; i++) {
+                    solution.steiner_points.push_back(file.point(i));
+                }
+
+                for (size_t i = 0; i < file.header().num_pairs; i++) {
+                    solution.edges.emplace_back(file.pairs()[2 * i], file.pairs()[2 * i + 1]);
+                }
+
+                solution.save(outputfile);
+            }
+        } else {
+            string text = readFile(inputfile);
+
+            // Solutions are the files with Steiner points
+            if (text.find("\"steiner_points_x\"") != string::npos) {
+                JsonExporter solution("");
+
+                readSolutionJson(text, solution);
+                BinaryFile::writeSolution(outputfile, solution.instance_uid, solution.content_type, solution.steiner_points, solution.edges);
+            } else {
+                JsonLoader loader;
+
+                loader.load(inputfile, true);
+                BinaryFile::writeInstance(outputfile, loader.getInstance(), loader.getMethod(), loader.getPoints(), loader.getConstraints(), loader.getRegionBoundaries(), loader.getParameters());
+            }
+        }
+    } catch (const std::exception& e) {
+        POLYG_LOG(ERROR, inputfile << ": " << e.what());
+        return 1;
+    }
+
+    POLYG_LOG(INFO, "Converted " << inputfile << " -> " << outputfile);
+
+    return 0;
+}
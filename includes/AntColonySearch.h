@@ -1,6 +1,9 @@
+#include <array>
 #include <gmp.h>
 #include <iostream>
 #include <map>
+#include <optional>
+#include <type_traits>
 #include <vector>
 
 // Macros and headers for CGAL
@@ -18,7 +21,14 @@
 // Support classes
 #include "AntColonyStructures.h"
 #include "JsonExporter.h"
+#include "Checkpoint.h"
+#include "Deadline.h"
 #include "JsonLoader.h"
+#include "ObtuseFaceWorklist.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "ThreadPool.h"
 #include "graph_definitions.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
@@ -26,46 +36,16 @@
 // Namespaces
 using namespace std;
 
-template <typename U>
+template <class Traits>
 class AntColonySearch {
+    // utils, steiner_strategies and the loader are built for the kernel of cgal_definitions.h
+    static_assert(std::is_same<typename Traits::CDT, CDT>::value, "Traits must match the kernel of this build (POLYG_EXACT_NT)");
+
 private:
     float calculateEnergy(float alpha, float beta, int obtuse_triangles, int steiner_points) {
         return alpha * obtuse_triangles + beta * steiner_points;
     }
 
-    float radius_to_height_ratio(const Point& p1, const Point& p2, const Point& p3) {
-        // Calculate side lengths of the triangle
-        float a = std::sqrt(CGAL::to_double(CGAL::squared_distance(p2, p3)));
-        float b = std::sqrt(CGAL::to_double(CGAL::squared_distance(p1, p3)));
-        float c = std::sqrt(CGAL::to_double(CGAL::squared_distance(p1, p2)));
-
-        // Calculate the semi-perimeter of the triangle
-        float s = (a + b + c) / 2.0f;
-
-        // Calculate the area of the triangle using Heron's formula
-        float area = std::sqrt(s * (s - a) * (s - b) * (s - c));
-
-        // Check if the area is zero to prevent division by zero
-        if (area == 0) {
-            std::cerr << "Degenerate triangle detected!" << std::endl;
-            return -1.0f; // Indicate an error
-        }
-
-        // Calculate the circumradius R
-        float R = (a * b * c) / (4.0f * area);
-
-        // Find the longest side
-        float longest_side = std::max({a, b, c});
-
-        // Calculate the height corresponding to the longest side
-        float height = (2.0f * area) / longest_side;
-
-        // Calculate the radius-to-height ratio
-        float rho = R / height;
-
-        return rho;
-    }
-
     float heuristic_function_vertex_projection(float p) {
         if (p <= 1.0) {
             return 0.0f;
@@ -150,7 +130,7 @@ private:
 
         // Ensure evaporation rate is within valid bounds
         if (evaporation_rate < 0.0f || evaporation_rate >= 1.0f) {
-            std::cerr << "Error: Evaporation rate (λ) must be in the range [0, 1)." << std::endl;
+            POLYG_LOG(ERROR, "Error: Evaporation rate (λ) must be in the range [0, 1).");
             exit(100);
         }
 
@@ -160,13 +140,13 @@ private:
         return updated_pheromone;
     }
 
-    int countObtuseNeighbors(Graph& graph, Point& a, Point& b, Point& c) {
+    int countObtuseNeighbors(Graph& graph, CDT::Face_handle& fit) {
         int counter = 0;
 
         for (int vertex_index = 0; vertex_index < 3; vertex_index++) {
             int neighbor_vertex_index = 0;
 
-            Face* face = utils::findNeighbor(graph, a, b, c, vertex_index, neighbor_vertex_index);
+            Face* face = utils::findNeighbor(*(graph.cdt), fit, vertex_index, neighbor_vertex_index);
 
             if (face != nullptr) {
                 if (utils::is_obtuse(face->vertex(0)->point(), face->vertex(1)->point(), face->vertex(2)->point())) {
@@ -178,14 +158,11 @@ private:
         return counter;
     }
 
-    int selectMethodByProbability(Graph& graph, vector<steiner_stategies::Strategy>& strategies, CDT::Face_handle& face, Pheromones& pheromones, float xi, float psi) {
-        Point a = face->vertex(0)->point();
-        Point b = face->vertex(1)->point();
-        Point c = face->vertex(2)->point();
-
-        int adjacent_obtuse_count = countObtuseNeighbors(graph, a, b, c);
+    int selectMethodByProbability(Graph& graph, vector<steiner_stategies::Strategy>& strategies, CDT::Face_handle& face, const steiner_stategies::TriangleGeometry& geometry,
+                                  Pheromones& pheromones, float xi, float psi) {
+        int adjacent_obtuse_count = countObtuseNeighbors(graph, face);
 
-        float p = radius_to_height_ratio(a, b, c);
+        float p = geometry.radius_to_height_ratio;
 
         float h_vertex_projection = heuristic_function_vertex_projection(p);
         float h_circumcenter = heuristic_function_circumcenter(p);
@@ -235,15 +212,17 @@ private:
         }
 
 
-        cout << "Probabilities: ";
+        if (POLYG_LOG_ENABLED(TRACE)) {
+            logging::Line line(logging::TRACE);
 
-        for (unsigned int i = 0; i < strategies.size(); i++) {
-            cout << cumulative_psp_values[i] << " " ;
-        }
+            line.stream() << "Probabilities: ";
 
-        cout << endl;
+            for (unsigned int i = 0; i < strategies.size(); i++) {
+                line.stream() << cumulative_psp_values[i] << " " ;
+            }
+        }
 
-        float random_variate = 0.01f * (rand() % 100);
+        double random_variate = rng::local().uniform();
 
         if (random_variate < cumulative_psp_values[0]) {
             return 0;
@@ -258,13 +237,57 @@ private:
         return (int)strategies.size() - 1;
     }
 
+    SearchState searchState(CDT& cdt, const vector<Point>& steinerPoints, int cycles, const Pheromones& pheromones, const rng::Generator& generator) {
+        SearchState state;
+
+        state.method = "ant";
+        state.iteration = cycles;
+        state.pheromones = pheromones.values;
+        state.rng = generator.state();
+        state.steiner_vertices = Checkpoint::idsOf(cdt, steinerPoints);
+
+        return state;
+    }
+
+    // Trial of one ant: located in the cycle's triangulation, evaluated by the pool
+    struct AntTrial {
+        bool generated;
+        bool evaluated;
+        CDT::Locate_type lt;
+        CDT::Face_handle loc;
+        int li;
+        int obtuse_triangles_after;
+    };
+
+    // Whether two insertions without flips split a common face (otherwise their order does not matter)
+    bool splitSameFace(AntTrial& trial1, AntTrial& trial2) {
+        if (trial1.lt == CDT::VERTEX || trial2.lt == CDT::VERTEX) {
+            return false;
+        }
+
+        CDT::Face_handle faces1[2] = {trial1.loc, trial1.lt == CDT::EDGE ? trial1.loc->neighbor(trial1.li) : trial1.loc};
+        CDT::Face_handle faces2[2] = {trial2.loc, trial2.lt == CDT::EDGE ? trial2.loc->neighbor(trial2.li) : trial2.loc};
+
+        for (CDT::Face_handle f1 : faces1) {
+            for (CDT::Face_handle f2 : faces2) {
+                if (f1 == f2) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
 public:
-    vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon, float alpha, float beta) {
+    vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon, float alpha, float beta, Deadline& deadline, Checkpoint& checkpoint) {
         vector<Point> steinerPoints;
         CDT& cdt = *(graph.cdt);
 
         unsigned int total_methods = strategies.size();
         Pheromones pheromones(total_methods);
+        ThreadPool pool(loader.getThreads());
+        rng::Generator& generator = rng::local(); // stream of the solving thread, seeded by the caller; the pool does not draw
 
         int MAX_ITERATIONS = loader.getL();
         float xi = loader.getXi();
@@ -274,39 +297,51 @@ public:
 
         int obtuse_triangles_initial = utils::countObtuseTriangles(cdt);
         int obtuse_triangles_after = 0;
+        int first_cycle = 0;
+
+        // Restored run: the triangulation is the checkpoint's, the search goes on from its state
+        if (checkpoint.resume) {
+            const SearchState& state = *checkpoint.resume;
 
-        cout << "# Initial Energy : " << calculateEnergy(alpha, beta, obtuse_triangles_initial, steinerPoints.size()) << endl;
-        cout << "# Max iterations : " << MAX_ITERATIONS << endl;
-        cout << "# Xi: " << xi << endl;
-        cout << "# Psi: " << psi << endl;
-        cout << "# Lambda: " << lambda << endl;
-        cout << "# Kappa : " << kappa << endl;
+            steinerPoints = Checkpoint::pointsOf(cdt, state.steiner_vertices);
+            first_cycle = state.iteration;
+            generator.setState(state.rng);
+
+            for (unsigned int i = 0; i < total_methods && i < state.pheromones.size(); i++) {
+                pheromones.values[i] = state.pheromones[i];
+            }
 
-        for (int loop = 0; loop < MAX_ITERATIONS; loop++) { // Cycles ...
+            POLYG_LOG(INFO, "# Resumed at cycle " << first_cycle << ", Pheromones = [" << pheromones << "]");
+        }
+
+        POLYG_LOG(INFO, "# Initial Energy : " << calculateEnergy(alpha, beta, obtuse_triangles_initial, steinerPoints.size()));
+        POLYG_LOG(INFO, "# Max iterations : " << MAX_ITERATIONS);
+        POLYG_LOG(INFO, "# Xi: " << xi);
+        POLYG_LOG(INFO, "# Psi: " << psi);
+        POLYG_LOG(INFO, "# Lambda: " << lambda);
+        POLYG_LOG(INFO, "# Kappa : " << kappa);
+        POLYG_LOG(INFO, "# Threads: " << pool.size());
+
+        ObtuseFaceWorklist worklist(cdt);
+
+        // A cycle is kept only if it lowers the energy, so the current state is
+        // always the best one: under a budget the search simply stops between cycles
+        for (int loop = first_cycle; loop < MAX_ITERATIONS && !deadline.expired(); loop++) { // Cycles ...
             int obtuse_triangles_before = utils::countObtuseTriangles(cdt);
             float E_current = calculateEnergy(alpha, beta, obtuse_triangles_before, steinerPoints.size());
             float E_next = 0;
 
-            cout << " *** Current Energy: " << E_current << ", Pheromones = [" << pheromones << "]" << endl;
-
-            std::vector<CDT::Face_handle> finite_faces; // all faces
-
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
+            POLYG_LOG(INFO, " *** Current Energy: " << E_current << ", Pheromones = [" << pheromones << "]");
 
+            // Obtuse faces from the worklist (valid when taken)
+            std::vector<std::array<CDT::Vertex_handle, 3>> obtuse_round = worklist.take_round();
             std::vector<CDT::Face_handle> obtuse_finite_faces; // obtuse faces
 
-            for (auto fit : finite_faces) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
-
-                bool result = utils::is_obtuse(a, b, c);
+            for (auto& face_vertices : obtuse_round) {
+                CDT::Face_handle fit;
 
-                if (result) {
-                    obtuse_finite_faces.push_back(fit);
-                }
+                cdt.is_face(face_vertices[0], face_vertices[1], face_vertices[2], fit);
+                obtuse_finite_faces.push_back(fit);
             }
 
             if (obtuse_finite_faces.size() == 0) { // Stop if no obtuse faces left
@@ -320,7 +355,7 @@ public:
             //
 
             for (int k = 0; k < kappa && obtuse_finite_faces.size() > 0; k++) {
-                int j = rand() % obtuse_finite_faces.size();
+                int j = (int)generator.below(obtuse_finite_faces.size());
 
                 CDT::Face_handle face = obtuse_finite_faces[j];
 
@@ -331,15 +366,20 @@ public:
 
             int workingAnts = obtuse_finite_face_per_ant.size();
 
-            cout << "Working ants: " << workingAnts << " from " << kappa << endl;
+            POLYG_LOG(DEBUG, "Working ants: " << workingAnts << " from " << kappa);
 
             //
             // Select triangulation method
             //
             vector<int> methodsPerAnt;
+            vector<steiner_stategies::TriangleGeometry> geometryPerAnt; // shared by the heuristics and the point generation
 
             for (int i = 0; i < workingAnts; i++) {
-                int m = selectMethodByProbability(graph, strategies, obtuse_finite_face_per_ant[i], pheromones, xi, psi);
+                CDT::Face_handle& face = obtuse_finite_face_per_ant[i];
+
+                geometryPerAnt.push_back(steiner_stategies::triangleGeometry(face->vertex(0)->point(), face->vertex(1)->point(), face->vertex(2)->point()));
+
+                int m = selectMethodByProbability(graph, strategies, face, geometryPerAnt[i], pheromones, xi, psi);
 
                 methodsPerAnt.push_back(m);
             }
@@ -347,92 +387,129 @@ public:
             //
             // Log
             //
+            vector<std::array<Point, 3>> verticesPerAnt; // the trials below may destroy the face handles
+            vector<CDT::Vertex_handle> cornerPerAnt;      // start of the point location for the trials
+
             for (int i = 0; i < workingAnts; i++) {
                 Point a = obtuse_finite_face_per_ant[i]->vertex(0)->point();
                 Point b = obtuse_finite_face_per_ant[i]->vertex(1)->point();
                 Point c = obtuse_finite_face_per_ant[i]->vertex(2)->point();
 
-                cout << "  Ant " << i << ": Face: " << a << " , " << b << " , " << c << " ";
-
-                steiner_stategies::printStrategy(strategies[methodsPerAnt[i]]);
+                verticesPerAnt.push_back({a, b, c});
+                cornerPerAnt.push_back(obtuse_finite_face_per_ant[i]->vertex(0));
 
-                cout << endl;
+                POLYG_LOG(DEBUG, "  Ant " << i << ": Face: " << a << " , " << b << " , " << c << " " << steiner_stategies::strategyLabel(strategies[methodsPerAnt[i]]));
             }
 
-            vector<Point*> pointsPerAnt;
-            vector<float> energyPerAnt;
+            vector<std::optional<Point>> pointsPerAnt(workingAnts);
+            vector<float> energyPerAnt(workingAnts, 0);
+            vector<AntTrial> trialPerAnt(workingAnts);
 
             //
-            // For each ant find steiner point and energy
+            // For each ant find steiner point and energy. The points are generated (and
+            // POLYGON, which adds constraints, tried in place) one ant at a time, then the
+            // other ants are located on the settled triangulation, and the pool evaluates
+            // them concurrently on local patches of it, each ant writing only its own slot
             //
+            int obtuse_triangles_now = utils::countObtuseTriangles(cdt);
+
             for (int i = 0; i < workingAnts; i++) {
-                CDT::Face_handle fit = obtuse_finite_face_per_ant[i];
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
+                std::array<Point, 3>& vertices = verticesPerAnt[i];
+                Point a = vertices[0];
+                Point b = vertices[1];
+                Point c = vertices[2];
                 int N = methodsPerAnt[i];
 
                 steiner_stategies::Strategy& selected_strategy = strategies[N];
+                AntTrial& trial = trialPerAnt[i];
 
-                CDT cdt_copy = cdt;
-                Graph graph_copy;
-                graph_copy.cdt = &cdt_copy;
+                trial.evaluated = true;
+                trial.obtuse_triangles_after = obtuse_triangles_now;
 
                 if (selected_strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
                     int i = utils::find_obtuse_angle(a, b, c);                      // 0:a, 1:b, 2:c
                     if (i == -1) {
-                        cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
+                        POLYG_LOG(ERROR, "CRITICAL ERROR: find_obtuse_angle failed ");
                         exit(1);
                     }
 
                     std::tuple<int, int> edge_indices = utils::findOppositeEdge(i); // a:1,2 b:0,2 c:0,1
 
-                    Point& p1 = fit->vertex(std::get<0>(edge_indices))->point();
-                    Point& p2 = fit->vertex(std::get<1>(edge_indices))->point();
+                    Point& p1 = vertices[std::get<0>(edge_indices)];
+                    Point& p2 = vertices[std::get<1>(edge_indices)];
 
-                    bool is_constraint = utils::checkConstraints(cdt_copy, p1, p2);
+                    bool is_constraint = utils::checkConstraints(cdt, p1, p2);
 
                     if (is_constraint) {
-                        pointsPerAnt.push_back(nullptr);
-                        energyPerAnt.push_back(0);
+                        trial.generated = false;
                         continue;
                     }
                 }
 
-                Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, selected_strategy);
+                bool in_place = selected_strategy == steiner_stategies::Strategy::POLYGON;
+
+                if (in_place) {
+                    cdt.begin_transaction();
+                }
+
+                steiner_stategies::SteinerPoint s = steiner_stategies::generateSteinerPoint(graph, geometryPerAnt[i], selected_strategy);
+
+                trial.generated = (bool)s;
+
+                if (s) {
+                    POLYG_LOG(TRACE, " i = " << i << " , " << *s);
 
-                if (s != nullptr) {
                     if (boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
-                        if (selected_strategy == steiner_stategies::Strategy::POLYGON) {
-                            cdt_copy.insert(*s);
+                        if (in_place) {
+                            cdt.insert(*s);
+                            trial.obtuse_triangles_after = utils::countObtuseTriangles(cdt);
                         } else {
-                            cdt_copy.insert_no_flip(*s);
+                            trial.evaluated = false;
                         }
 
-                        pointsPerAnt.push_back(s);
-                    } else {
-                        pointsPerAnt.push_back(nullptr);
+                        pointsPerAnt[i] = std::move(s.point);
                     }
+                }
 
-                    cout << " i = " << i << " , " << *s << endl;
+                if (in_place) {
+                    cdt.rollback();
+                }
+            }
+
+            // Located once every in-place trial is rolled back: a rollback does not
+            // restore the faces a constraint of POLYGON destroyed
+            for (int i = 0; i < workingAnts; i++) {
+                AntTrial& trial = trialPerAnt[i];
 
-                    int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy);
+                if (!trial.evaluated) {
+                    trial.loc = cdt.locate(*pointsPerAnt[i], trial.lt, trial.li, cornerPerAnt[i]->face());
 
-                    float E_next = calculateEnergy(alpha, beta, copy_obtuse_triangles_after, steinerPoints.size() + 1);
+                    // The lazy values the threads share are computed here, serially
+                    if (pool.size() > 1) {
+                        cdt.make_patch_exact(*pointsPerAnt[i], trial.loc, LOCAL_PATCH_RINGS);
+                    }
+                }
+            }
 
-                    energyPerAnt.push_back(E_next);
+            pool.run(workingAnts, [&](int i) {
+                AntTrial& trial = trialPerAnt[i];
+                int delta = 0;
 
-                    // cout << "\t";
-                    // steiner_stategies::printStrategy(selected_strategy);
-                    // cout << " - New energy: " << E_next << " - Method succeeded " << copy_obtuse_triangles_after << endl;
+                if (!trial.evaluated) {
+                    trial.evaluated = cdt.patch_obtuse_delta(*pointsPerAnt[i], false, trial.lt, trial.loc, trial.li, LOCAL_PATCH_RINGS, delta);
+                    trial.obtuse_triangles_after += delta;
+                }
+            });
 
-                    // --------------------------------------------------------- energy
-                } else {
-                    // cout << "\t";
-                    // steiner_stategies::printStrategy(selected_strategy);
-                    // cout << " - New energy: " << E_next << " - Method failed    " << endl;
-                    energyPerAnt.push_back(0);
-                    pointsPerAnt.push_back(nullptr);
+            for (int i = 0; i < workingAnts; i++) {
+                AntTrial& trial = trialPerAnt[i];
+
+                if (!trial.evaluated) { // point on the border of its patch
+                    trial.obtuse_triangles_after = obtuse_triangles_now + cdt.obtuse_delta_of_insertion(*pointsPerAnt[i], false, cornerPerAnt[i]->face(), LOCAL_PATCH_RINGS);
+                }
+
+                if (trial.generated) {
+                    energyPerAnt[i] = calculateEnergy(alpha, beta, trial.obtuse_triangles_after, steinerPoints.size() + 1);
                 }
             }
 
@@ -441,16 +518,16 @@ public:
             //
 
             for (int i = 0; i < workingAnts; i++) {
-                if (pointsPerAnt[i] != nullptr) {
+                if (pointsPerAnt[i]) {
                     bool reduces_energy = energyPerAnt[i] < E_current;
 
-                    cout << "  Ant " << i << " : " << *pointsPerAnt[i] << ", energy: " << energyPerAnt[i] << ", reduces energy: " << (reduces_energy ? "true" : "false") << endl;
+                    POLYG_LOG(DEBUG, "  Ant " << i << " : " << *pointsPerAnt[i] << ", energy: " << energyPerAnt[i] << ", reduces energy: " << (reduces_energy ? "true" : "false"));
 
                     if (!reduces_energy) {
-                        pointsPerAnt[i] = nullptr;
+                        pointsPerAnt[i].reset();
                     }
                 } else {
-                    cout << "  Ant " << i << " : " << "null" << ", energy: " << energyPerAnt[i] << endl;
+                    POLYG_LOG(DEBUG, "  Ant " << i << " : " << "null" << ", energy: " << energyPerAnt[i]);
                 }
             }
 
@@ -459,54 +536,64 @@ public:
             //
             for (int i = 0; i < workingAnts; i++) {
                 for (int j = i + 1; j < workingAnts; j++) {
-                    if (pointsPerAnt[i] != nullptr && pointsPerAnt[j] != nullptr) {
+                    if (pointsPerAnt[i] && pointsPerAnt[j]) {
                         int selected_strategy1 = methodsPerAnt[i];
                         int selected_strategy2 = methodsPerAnt[j];
-                        Point* s1 = pointsPerAnt[i];
-                        Point* s2 = pointsPerAnt[j];
+                        const Point& s1 = *pointsPerAnt[i];
+                        const Point& s2 = *pointsPerAnt[j];
                         float energy1 = energyPerAnt[i];
                         float energy2 = energyPerAnt[j];
 
-                        CDT cdt_copy_1 = cdt;
-                        CDT cdt_copy_2 = cdt;
+                        if (strategies[selected_strategy1] != steiner_stategies::Strategy::POLYGON && strategies[selected_strategy2] != steiner_stategies::Strategy::POLYGON &&
+                            !splitSameFace(trialPerAnt[i], trialPerAnt[j])) {
+                            continue; // the two insertions commute
+                        }
+
+                        // Both insertion orders, one after the other in place
+                        cdt.begin_transaction();
 
                         if (selected_strategy1 == steiner_stategies::Strategy::POLYGON) {
-                            cdt_copy_1.insert(*s1);
+                            cdt.insert(s1);
                         } else {
-                            cdt_copy_1.insert_no_flip(*s1);
+                            cdt.insert_no_flip(s1);
                         }
 
                         if (selected_strategy2 == steiner_stategies::Strategy::POLYGON) {
-                            cdt_copy_1.insert(*s2);
+                            cdt.insert(s2);
                         } else {
-                            cdt_copy_1.insert_no_flip(*s2);
+                            cdt.insert_no_flip(s2);
                         }
 
+                        int obtuse_triangles_1 = utils::countObtuseTriangles(cdt);
+
+                        cdt.rollback();
+                        cdt.begin_transaction();
+
                         if (selected_strategy1 == steiner_stategies::Strategy::POLYGON) {
-                            cdt_copy_2.insert(*s2);
+                            cdt.insert(s2);
                         } else {
-                            cdt_copy_2.insert_no_flip(*s2);
+                            cdt.insert_no_flip(s2);
                         }
 
                         if (selected_strategy2 == steiner_stategies::Strategy::POLYGON) {
-                            cdt_copy_2.insert(*s1);
+                            cdt.insert(s1);
                         } else {
-                            cdt_copy_2.insert_no_flip(*s1);
+                            cdt.insert_no_flip(s1);
                         }
 
-                        // Compute some metric for cdt_copy_1 and cdt_copy_2
-                        int obtuse_triangles_1 = utils::countObtuseTriangles(cdt_copy_1);
-                        int obtuse_triangles_2 = utils::countObtuseTriangles(cdt_copy_2);
+                        int obtuse_triangles_2 = utils::countObtuseTriangles(cdt);
+
+                        cdt.rollback();
 
                         if (obtuse_triangles_1 != obtuse_triangles_2)
                         {
                             if (energy1 < energy2)
                             {
-                                pointsPerAnt[j] = nullptr;
+                                pointsPerAnt[j].reset();
                             }
                             else
                             {
-                                pointsPerAnt[i] = nullptr;
+                                pointsPerAnt[i].reset();
                             }
                         }
                     }
@@ -516,25 +603,26 @@ public:
             //
             // Find combined energy
             //
-            CDT cdt_copy = cdt;
+            cdt.begin_transaction();
+
             for (int i = 0; i < workingAnts; i++) {
-                if (pointsPerAnt[i] != nullptr) {
+                if (pointsPerAnt[i]) {
                     int selected_strategy = methodsPerAnt[i];
-                    Point* s = pointsPerAnt[i];
+                    const Point& s = *pointsPerAnt[i];
 
                     if (selected_strategy == steiner_stategies::Strategy::POLYGON) {
-                        cdt_copy.insert(*s);
+                        cdt.insert(s);
                     } else {
-                        cdt_copy.insert_no_flip(*s);
+                        cdt.insert_no_flip(s);
                     }
                 }
             }
 
-            int copy_obtuse_triangles_after_all_ants = utils::countObtuseTriangles(cdt_copy);
+            int copy_obtuse_triangles_after_all_ants = utils::countObtuseTriangles(cdt);
             int added_points = 0;
 
             for (int i = 0; i < workingAnts; i++) {
-                if (pointsPerAnt[i] != nullptr) {
+                if (pointsPerAnt[i]) {
                     added_points++;
                 }
             }
@@ -543,20 +631,16 @@ public:
 
             if (E_next_all_ants < E_current) {
                 //
-                // Apply triangulation
+                // Apply triangulation (already in place)
                 //
-                for (int i = 0; i < workingAnts; i++) {
-                    if (pointsPerAnt[i] != nullptr) {
-                        int selected_strategy = methodsPerAnt[i];
-                        Point* s = pointsPerAnt[i];
+                cdt.commit();
 
-                        if (selected_strategy == steiner_stategies::Strategy::POLYGON) {
-                            cdt.insert(*s);
-                        } else {
-                            cdt.insert_no_flip(*s);
-                        }
+                POLYG_COUNT(MOVES_ACCEPTED);
 
-                        steinerPoints.push_back(*s);
+                for (int i = 0; i < workingAnts; i++) {
+                    if (pointsPerAnt[i]) {
+                        steinerPoints.push_back(*pointsPerAnt[i]);
+                        POLYG_COUNT_INSERTION(strategies[methodsPerAnt[i]]);
                     }
                 }
 
@@ -573,27 +657,42 @@ public:
                 for (unsigned int i = 0; i < total_methods; i++) {
                     float delta_pheromone = pheromone_reinforcement(reduced_obtuse_triangles, obtuse_triangles_after, steinerPoints.size(), alpha, beta);
                     pheromones.values[i] = pheromone_evaporation_and_reinforcement(pheromones.values[i], delta_pheromone, lambda);
+                    POLYG_COUNT(PHEROMONE_UPDATES);
 
-                    cout << "pheromone: " << i << " changed to : " << pheromones.values[i] << endl;
+                    POLYG_LOG(TRACE, "pheromone: " << i << " changed to : " << pheromones.values[i]);
                 }
+            } else {
+                POLYG_COUNT(MOVES_REJECTED);
+
+                cdt.rollback();
             }
 
-            cout << " ### Cycle: " << loop << " - Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before;
+            // Faces the cycle did not fix stay for the next one
+            worklist.requeue(obtuse_round);
+
+            POLYG_LOG(INFO, " ### Cycle: " << loop << " - Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before
+                      << " Energy: " << E_current << " updated to " << E_next);
 
-            cout << " Energy: " << E_current << " updated to " << E_next << endl;
+            if (checkpoint.due() || (checkpoint.enabled() && deadline.expired())) {
+                checkpoint.save(cdt, searchState(cdt, steinerPoints, loop + 1, pheromones, generator));
+            }
         }
         
+        if (deadline.expired()) {
+            POLYG_LOG(INFO, "# Search stopped: time budget or cancellation");
+        }
+
         obtuse_triangles_after = utils::countObtuseTriangles(cdt);
 
-        cout << "***********************************************************************" << endl;
-        cout << " - Initial obtuse triangles: " << obtuse_triangles_initial << endl;
-        cout << " - Total obtuse triangles  : " << obtuse_triangles_after << endl;
-        cout << " - Total steiner points    : " << steinerPoints.size() << endl;
-        cout << " - Energy - Initial        : " << alpha * obtuse_triangles_initial << endl;
-        cout << " - Energy - Final          : " << alpha * obtuse_triangles_after + beta * steinerPoints.size() << endl;
-        cout << " - Alpha                   : " << alpha << endl;
-        cout << " - Beta                    : " << beta << endl;
-        cout << "***********************************************************************" << endl;
+        POLYG_LOG(INFO, "***********************************************************************");
+        POLYG_LOG(INFO, " - Initial obtuse triangles: " << obtuse_triangles_initial);
+        POLYG_LOG(INFO, " - Total obtuse triangles  : " << obtuse_triangles_after);
+        POLYG_LOG(INFO, " - Total steiner points    : " << steinerPoints.size());
+        POLYG_LOG(INFO, " - Energy - Initial        : " << alpha * obtuse_triangles_initial);
+        POLYG_LOG(INFO, " - Energy - Final          : " << alpha * obtuse_triangles_after + beta * steinerPoints.size());
+        POLYG_LOG(INFO, " - Alpha                   : " << alpha);
+        POLYG_LOG(INFO, " - Beta                    : " << beta);
+        POLYG_LOG(INFO, "***********************************************************************");
 
         return steinerPoints;
     }
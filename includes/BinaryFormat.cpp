@@ -0,0 +1,506 @@
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BinaryFormat.h"
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = {'P', 'O', 'L', 'Y', 'G', 'B', 'I', 'N'};
+
+// Largest integer coordinate of the fixed-width section: exact in a double
+const int64_t MAX_INTEGER_COORDINATE = int64_t(1) << 53;
+
+// Magnitude of an integer as little-endian bytes (none for 0), and its sign:
+// through the decimal digits for any exact type, GMP exports them directly
+template <typename Integer>
+bool integerBytes(const Integer& z, string& bytes) {
+    thread_local std::ostringstream stream;
+
+    stream.str("");
+    stream << z;
+
+    string digits = stream.str();
+    bool negative = !digits.empty() && digits[0] == '-';
+    vector<int> decimal;
+
+    for (char c : digits) {
+        if (c >= '0' && c <= '9' && (c != '0' || !decimal.empty())) {
+            decimal.push_back(c - '0');
+        }
+    }
+
+    bytes.clear();
+
+    // Long division of the digits by 256, one byte per round
+    while (!decimal.empty()) {
+        vector<int> quotient;
+        int remainder = 0;
+
+        for (int digit : decimal) {
+            int current = remainder * 10 + digit;
+
+            if (current >= 256 || !quotient.empty()) {
+                quotient.push_back(current / 256);
+            }
+            remainder = current % 256;
+        }
+
+        bytes += char(remainder);
+        decimal.swap(quotient);
+    }
+
+    return negative;
+}
+
+#ifdef CGAL_USE_GMP
+bool integerBytes(const CGAL::Gmpz& z, string& bytes) {
+    size_t count = (mpz_sizeinbase(z.mpz(), 2) + 7) / 8;
+
+    bytes.resize(count);
+    mpz_export(&bytes[0], &count, -1, 1, -1, 0, z.mpz());
+    bytes.resize(count);
+
+    return mpz_sgn(z.mpz()) < 0;
+}
+#endif
+
+#ifdef CGAL_USE_GMPXX
+bool integerBytes(const mpz_class& z, string& bytes) {
+    size_t count = (mpz_sizeinbase(z.get_mpz_t(), 2) + 7) / 8;
+
+    bytes.resize(count);
+    mpz_export(&bytes[0], &count, -1, 1, -1, 0, z.get_mpz_t());
+    bytes.resize(count);
+
+    return mpz_sgn(z.get_mpz_t()) < 0;
+}
+#endif
+
+// Exact value of little-endian magnitude bytes: 6 bytes (48 bits) fit a
+// double exactly, so they are accumulated 6 at a time
+K::FT integerValue(const unsigned char* bytes, size_t n) {
+    K::FT value(0);
+
+    while (n > 0) {
+        size_t k = n % 6 == 0 ? 6 : n % 6;
+        int64_t chunk = 0;
+
+        for (size_t j = 0; j < k; j++) {
+            chunk = (chunk << 8) | bytes[n - 1 - j];
+        }
+
+        n -= k;
+        value = value * K::FT(double(int64_t(1) << (8 * k))) + K::FT(double(chunk));
+    }
+
+    return value;
+}
+
+struct ExactCoordinate {
+    bool negative;
+    string numerator;
+    string denominator;
+};
+
+ExactCoordinate exactCoordinate(const K::FT& coord) {
+    typedef CGAL::Fraction_traits<K::FT::ET> Traits;
+
+    Traits::Numerator_type num;
+    Traits::Denominator_type den;
+
+    Traits::Decompose()(CGAL::exact(coord), num, den);
+
+    ExactCoordinate result;
+    result.negative = integerBytes(num, result.numerator);
+    integerBytes(den, result.denominator);
+
+    return result;
+}
+
+// The coordinate as a fixed-width integer, if it is one
+bool integerCoordinate(const ExactCoordinate& coord, int64_t& value) {
+    if (coord.denominator != string(1, '\1') || coord.numerator.size() > 7) {
+        return false;
+    }
+
+    value = 0;
+
+    for (size_t i = coord.numerator.size(); i-- > 0;) {
+        value = (value << 8) | (unsigned char)coord.numerator[i];
+    }
+
+    if (value > MAX_INTEGER_COORDINATE) {
+        return false;
+    }
+
+    value = coord.negative ? -value : value;
+
+    return true;
+}
+
+//
+// Image of a file, built in memory and written at once
+//
+class Image {
+public:
+    Image() {
+        bytes.resize(sizeof(BinaryHeader));
+    }
+
+    BinaryHeader& header() {
+        return *reinterpret_cast<BinaryHeader*>(&bytes[0]);
+    }
+
+    // Starts a section on 8 bytes and returns its offset
+    uint64_t section() {
+        bytes.resize((bytes.size() + 7) & ~size_t(7));
+        return bytes.size();
+    }
+
+    void append(const void* data, size_t length) {
+        bytes.append(static_cast<const char*>(data), length);
+    }
+
+    template <typename T>
+    void append(const T& value) {
+        append(&value, sizeof(T));
+    }
+
+    void appendString(const string& s) {
+        append(uint32_t(s.size()));
+        append(s.data(), s.size());
+    }
+
+    void appendPairs(const vector<std::pair<int, int>>& pairs) {
+        for (const auto& pair : pairs) {
+            append(int32_t(pair.first));
+            append(int32_t(pair.second));
+        }
+    }
+
+    //
+    // Coordinates in the fixed-width section if they are all small integers,
+    // in the rational one otherwise
+    //
+    void appendCoordinates(const vector<Point>& points) {
+        vector<ExactCoordinate> exact[2];
+        vector<int64_t> integers[2];
+        bool all_integers = true;
+
+        for (int axis = 0; axis < 2; axis++) {
+            exact[axis].reserve(points.size());
+            integers[axis].reserve(points.size());
+
+            for (const Point& p : points) {
+                exact[axis].push_back(exactCoordinate(axis == 0 ? p.x() : p.y()));
+
+                int64_t value = 0;
+                all_integers = all_integers && integerCoordinate(exact[axis].back(), value);
+                integers[axis].push_back(value);
+            }
+        }
+
+        header().num_points = uint32_t(points.size());
+
+        if (all_integers) {
+            header().flags |= BinaryFile::INTEGER_COORDINATES;
+            header().coordinates = section();
+
+            for (int axis = 0; axis < 2; axis++) {
+                append(integers[axis].data(), integers[axis].size() * sizeof(int64_t));
+            }
+
+            header().rationals = section();
+            return;
+        }
+
+        header().coordinates = section();
+        header().rationals = section();
+
+        uint64_t start = bytes.size();
+        uint64_t table = start;
+
+        bytes.resize(bytes.size() + 2 * points.size() * sizeof(uint64_t));
+
+        for (int axis = 0; axis < 2; axis++) {
+            for (const ExactCoordinate& coord : exact[axis]) {
+                uint64_t offset = section() - start;
+                memcpy(&bytes[table], &offset, sizeof(offset));
+                table += sizeof(offset);
+
+                BinaryRational record = {};
+                record.negative = coord.negative ? 1 : 0;
+                record.numerator_bytes = uint32_t(coord.numerator.size());
+                record.denominator_bytes = uint32_t(coord.denominator.size());
+
+                append(record);
+                append(coord.numerator.data(), coord.numerator.size());
+                append(coord.denominator.data(), coord.denominator.size());
+            }
+        }
+    }
+
+    void save(const char* path) {
+        header().size = section();
+
+        ofstream file(path, ios::binary | ios::trunc);
+        file.write(bytes.data(), bytes.size());
+        file.close();
+
+        if (!file) {
+            throw runtime_error(string("cannot write ") + path);
+        }
+    }
+
+private:
+    string bytes;
+};
+
+} // namespace
+
+BinaryFile::BinaryFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        throw runtime_error(string("cannot open ") + path);
+    }
+
+    struct stat status;
+
+    if (fstat(fd, &status) != 0 || status.st_size < (off_t)sizeof(BinaryHeader)) {
+        close(fd);
+        throw runtime_error(string("not a binary instance or solution: ") + path);
+    }
+
+    size = (size_t)status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        throw runtime_error(string("cannot map ") + path);
+    }
+
+    data = static_cast<const char*>(mapping);
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    //
+    // Every section inside the file, so that the accessors need no checks
+    //
+    const BinaryHeader& h = header();
+    bool integers = (h.flags & INTEGER_COORDINATES) != 0;
+
+    try {
+        if (memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.size != size) {
+            throw runtime_error("not a binary instance or solution");
+        }
+
+        if (h.version != VERSION || (h.kind != INSTANCE && h.kind != SOLUTION)) {
+            throw runtime_error("unsupported version or kind");
+        }
+
+        text(0);
+        text(1);
+        at(h.coordinates, integers ? 2 * sizeof(int64_t) * (uint64_t)h.num_points : 0);
+        at(h.pairs, 2 * sizeof(int32_t) * (uint64_t)h.num_pairs);
+        at(h.boundary, sizeof(int32_t) * (uint64_t)h.num_boundary);
+        at(h.parameters, sizeof(BinaryParameter) * (uint64_t)h.num_parameters);
+
+        if (!integers) {
+            const uint64_t* offsets = reinterpret_cast<const uint64_t*>(at(h.rationals, 2 * sizeof(uint64_t) * (uint64_t)h.num_points));
+
+            for (uint64_t i = 0; i < 2 * (uint64_t)h.num_points; i++) {
+                if (offsets[i] > size) {
+                    throw runtime_error("section out of the file");
+                }
+
+                const BinaryRational* record = reinterpret_cast<const BinaryRational*>(at(h.rationals + offsets[i], sizeof(BinaryRational)));
+
+                if (record->denominator_bytes == 0) {
+                    throw runtime_error("zero denominator");
+                }
+
+                at(h.rationals + offsets[i] + sizeof(BinaryRational), (uint64_t)record->numerator_bytes + record->denominator_bytes);
+            }
+        }
+    } catch (const std::exception& e) {
+        munmap(const_cast<char*>(data), size);
+        throw runtime_error(string(e.what()) + ": " + path);
+    }
+}
+
+BinaryFile::~BinaryFile() {
+    munmap(const_cast<char*>(data), size);
+}
+
+bool BinaryFile::isBinary(const char* path) {
+    char magic[sizeof(MAGIC)] = {};
+    ifstream file(path, ios::binary);
+
+    file.read(magic, sizeof(magic));
+
+    return file && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+const char* BinaryFile::at(uint64_t offset, uint64_t length) const {
+    if (offset % 8 != 0 || offset > size || length > size - offset) {
+        throw runtime_error("section out of the file");
+    }
+
+    return data + offset;
+}
+
+string BinaryFile::text(int index) const {
+    uint64_t offset = header().strings;
+
+    for (int i = 0;; i++) {
+        uint32_t length;
+        memcpy(&length, at(offset, sizeof(length)), sizeof(length));
+
+        const char* characters = at(offset, sizeof(length) + (uint64_t)length) + sizeof(length);
+
+        if (i == index) {
+            return string(characters, length);
+        }
+
+        offset = (offset + sizeof(length) + length + 7) & ~uint64_t(7);
+    }
+}
+
+string BinaryFile::instanceUid() const {
+    return text(0);
+}
+
+string BinaryFile::label() const {
+    return text(1);
+}
+
+const int64_t* BinaryFile::integerCoordinates(int axis) const {
+    if ((header().flags & INTEGER_COORDINATES) == 0) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const int64_t*>(data + header().coordinates) + (axis == 0 ? 0 : header().num_points);
+}
+
+K::FT BinaryFile::coordinate(size_t i, int axis) const {
+    if (const int64_t* integers = integerCoordinates(axis)) {
+        return K::FT(double(integers[i]));
+    }
+
+    const char* section = data + header().rationals;
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(section);
+    const char* record_start = section + offsets[(axis == 0 ? 0 : header().num_points) + i];
+    const BinaryRational* record = reinterpret_cast<const BinaryRational*>(record_start);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(record + 1);
+
+    K::FT value = integerValue(bytes, record->numerator_bytes);
+
+    if (record->denominator_bytes != 1 || bytes[record->numerator_bytes] != 1) {
+        value = value / integerValue(bytes + record->numerator_bytes, record->denominator_bytes);
+    }
+
+    return record->negative ? -value : value;
+}
+
+Point BinaryFile::point(size_t i) const {
+    return Point(coordinate(i, 0), coordinate(i, 1));
+}
+
+const int32_t* BinaryFile::pairs() const {
+    return reinterpret_cast<const int32_t*>(data + header().pairs);
+}
+
+const int32_t* BinaryFile::boundary() const {
+    return reinterpret_cast<const int32_t*>(data + header().boundary);
+}
+
+map<string, double> BinaryFile::parameters() const {
+    map<string, double> result;
+    const BinaryParameter* parameter = reinterpret_cast<const BinaryParameter*>(data + header().parameters);
+
+    for (uint32_t i = 0; i < header().num_parameters; i++, parameter++) {
+        result[string(parameter->name, strnlen(parameter->name, sizeof(parameter->name)))] = parameter->value;
+    }
+
+    return result;
+}
+
+void BinaryFile::writeInstance(const char* path, const string& instance_uid, const string& method, const vector<Point>& points, const vector<std::pair<int, int>>& constraints, const vector<int>& boundary, const map<string, double>& parameters) {
+    Image image;
+    BinaryHeader header = {};
+
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.kind = INSTANCE;
+    image.header() = header;
+
+    image.header().strings = image.section();
+    image.appendString(instance_uid);
+    image.section();
+    image.appendString(method);
+
+    image.appendCoordinates(points);
+
+    image.header().num_pairs = uint32_t(constraints.size());
+    image.header().pairs = image.section();
+    image.appendPairs(constraints);
+
+    image.header().num_boundary = uint32_t(boundary.size());
+    image.header().boundary = image.section();
+    for (int index : boundary) {
+        image.append(int32_t(index));
+    }
+
+    image.header().num_parameters = uint32_t(parameters.size());
+    image.header().parameters = image.section();
+    for (const auto& entry : parameters) {
+        BinaryParameter parameter = {};
+
+        if (entry.first.size() >= sizeof(parameter.name)) {
+            throw runtime_error("parameter name too long: " + entry.first);
+        }
+
+        memcpy(parameter.name, entry.first.data(), entry.first.size());
+        parameter.value = entry.second;
+        image.append(parameter);
+    }
+
+    image.save(path);
+}
+
+void BinaryFile::writeSolution(const char* path, const string& instance_uid, const string& content_type, const vector<Point>& steiner_points, const vector<std::pair<int, int>>& edges) {
+    Image image;
+    BinaryHeader header = {};
+
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.kind = SOLUTION;
+    image.header() = header;
+
+    image.header().strings = image.section();
+    image.appendString(instance_uid);
+    image.section();
+    image.appendString(content_type);
+
+    image.appendCoordinates(steiner_points);
+
+    image.header().num_pairs = uint32_t(edges.size());
+    image.header().pairs = image.section();
+    image.appendPairs(edges);
+
+    image.header().boundary = image.section();
+    image.header().parameters = image.section();
+
+    image.save(path);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+// Macros for CGAL
+#include "cgal_definitions.h"
+
+// Standard C++
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Namespaces
+using namespace std;
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the binary format is read in place: little-endian hosts only"
+#endif
+
+//
+// Binary instances and solutions (*.bin), an alternative to the CG:SHOP
+// JSON for large inputs. Every section starts on 8 bytes, at the offset
+// given in the header, and is read in place from the mapped file:
+//  - strings: instance_uid, then the method (instance) or the content type
+//    (solution), each as a uint32 length and its bytes,
+//  - coordinates: int64 x[num_points] then y[num_points], when every
+//    coordinate is an integer of at most 53 bits (INTEGER_COORDINATES),
+//  - pairs: int32 [2 * num_pairs], the additional constraints or the edges,
+//  - boundary: int32 [num_boundary], the region boundary of an instance,
+//  - parameters: BinaryParameter [num_parameters],
+//  - rationals: without INTEGER_COORDINATES, the exact coordinates: uint64
+//    offsets of x[num_points] then y[num_points] (from the section start),
+//    each to a BinaryRational and the little-endian bytes of the magnitudes
+//    of its numerator and denominator.
+//
+struct BinaryHeader {
+    char magic[8];          // "POLYGBIN"
+    uint32_t version;
+    uint32_t kind;          // BinaryFile::INSTANCE or BinaryFile::SOLUTION
+    uint32_t flags;
+    uint32_t num_points;    // points of the instance, Steiner points of the solution
+    uint32_t num_pairs;     // additional constraints, or edges
+    uint32_t num_boundary;
+    uint32_t num_parameters;
+    uint32_t reserved;
+    uint64_t strings;
+    uint64_t coordinates;
+    uint64_t pairs;
+    uint64_t boundary;
+    uint64_t parameters;
+    uint64_t rationals;
+    uint64_t size;          // of the whole file
+};
+
+static_assert(sizeof(BinaryHeader) == 96, "the header is part of the file format");
+
+struct BinaryParameter {
+    char name[24];          // zero-padded
+    double value;
+};
+
+struct BinaryRational {
+    uint32_t negative;
+    uint32_t numerator_bytes;
+    uint32_t denominator_bytes;
+    uint32_t reserved;
+};
+
+//
+// A binary file mapped read-only: the arrays point into the mapping and live
+// as long as the object. Malformed files throw std::runtime_error.
+//
+class BinaryFile {
+public:
+    enum Kind {
+        INSTANCE = 1,
+        SOLUTION = 2,
+    };
+
+    enum Flags {
+        INTEGER_COORDINATES = 1,
+    };
+
+    static const uint32_t VERSION = 1;
+
+    explicit BinaryFile(const char* path);
+    ~BinaryFile();
+
+    BinaryFile(const BinaryFile&) = delete;
+    BinaryFile& operator=(const BinaryFile&) = delete;
+
+    // The file starts with the magic of the format
+    static bool isBinary(const char* path);
+
+    const BinaryHeader& header() const {
+        return *reinterpret_cast<const BinaryHeader*>(data);
+    }
+
+    string instanceUid() const;
+
+    // Method of an instance, content type of a solution
+    string label() const;
+
+    // x (axis 0) or y (axis 1) of every point, nullptr without INTEGER_COORDINATES
+    const int64_t* integerCoordinates(int axis) const;
+
+    // Exact coordinate of point i, from either section
+    K::FT coordinate(size_t i, int axis) const;
+
+    Point point(size_t i) const;
+
+    const int32_t* pairs() const;
+
+    const int32_t* boundary() const;
+
+    map<string, double> parameters() const;
+
+    static void writeInstance(const char* path, const string& instance_uid, const string& method, const vector<Point>& points, const vector<std::pair<int, int>>& constraints, const vector<int>& boundary, const map<string, double>& parameters);
+
+    static void writeSolution(const char* path, const string& instance_uid, const string& content_type, const vector<Point>& steiner_points, const vector<std::pair<int, int>>& edges);
+
+private:
+    // Bounds-checked start of length bytes at offset
+    const char* at(uint64_t offset, uint64_t length) const;
+
+    string text(int index) const;
+
+    const char* data = nullptr;
+    size_t size = 0;
+};
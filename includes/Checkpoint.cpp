@@ -0,0 +1,288 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Checkpoint.h"
+#include "JsonCursor.h"
+#include "Log.h"
+#include "utils.hpp"
+
+using namespace std;
+
+namespace {
+
+void appendNumber(string& out, const char* format, double value) {
+    char digits[32];
+    snprintf(digits, sizeof(digits), format, value);
+    out += digits;
+}
+
+// 64-bit values as strings: JSON readers keep only 53 bits of numbers
+void appendUnsigned(string& out, uint64_t value) {
+    out += '"';
+    out += std::to_string(value);
+    out += '"';
+}
+
+uint64_t parseUnsigned(JsonCursor& cursor) {
+    string text = cursor.parseString();
+    char* stop = nullptr;
+    uint64_t value = strtoull(text.c_str(), &stop, 10);
+
+    if (text.empty() || *stop != '\0') {
+        cursor.fail("expected an unsigned integer");
+    }
+
+    return value;
+}
+
+} // namespace
+
+Checkpoint::Checkpoint(const string& path, double interval_seconds) : path(path), interval(interval_seconds) {
+    last = std::chrono::steady_clock::now();
+}
+
+bool Checkpoint::due() const {
+    return enabled() && std::chrono::duration<double>(std::chrono::steady_clock::now() - last).count() >= interval;
+}
+
+void Checkpoint::save(CDT& cdt, const SearchState& state) {
+    std::vector<Vertex_handle> vertices(cdt.number_of_vertices());
+
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        vertices[vit->id()] = vit;
+    }
+
+    string text;
+    text.reserve(vertices.size() * 48);
+
+    text += "{\n\"content_type\": \"polyg_checkpoint\",\n\"method\": \"";
+    text += state.method;
+    text += "\",\n\"seed\": ";
+    appendUnsigned(text, seed);
+    text += ",\n\"iteration\": ";
+    text += std::to_string(state.iteration);
+    text += ",\n\"temperature\": ";
+    appendNumber(text, "%.9g", state.temperature);
+
+    text += ",\n\"rng\": [";
+    for (size_t i = 0; i < state.rng.size(); i++) {
+        text += i == 0 ? "" : ", ";
+        appendUnsigned(text, state.rng[i]);
+    }
+
+    text += "],\n\"pheromones\": [";
+    for (size_t i = 0; i < state.pheromones.size(); i++) {
+        text += i == 0 ? "" : ", ";
+        appendNumber(text, "%.9g", state.pheromones[i]);
+    }
+
+    text += "],\n\"vertices\": [";
+    for (size_t i = 0; i < vertices.size(); i++) {
+        text += i == 0 ? "\n[\"" : ",\n[\"";
+        utils::append_rational(text, vertices[i]->point().x());
+        text += "\", \"";
+        utils::append_rational(text, vertices[i]->point().y());
+        text += "\"]";
+    }
+
+    text += "],\n\"constraints\": [";
+    bool first = true;
+    for (auto eit = cdt.finite_edges_begin(); eit != cdt.finite_edges_end(); ++eit) {
+        if (!cdt.is_constrained(*eit)) {
+            continue;
+        }
+
+        text += first ? "\n[" : ",\n[";
+        text += std::to_string(eit->first->vertex(cdt.cw(eit->second))->id());
+        text += ", ";
+        text += std::to_string(eit->first->vertex(cdt.ccw(eit->second))->id());
+        text += "]";
+        first = false;
+    }
+
+    text += "],\n\"steiner_vertices\": [";
+    for (size_t i = 0; i < state.steiner_vertices.size(); i++) {
+        text += i == 0 ? "" : ", ";
+        text += std::to_string(state.steiner_vertices[i]);
+    }
+
+    text += "]\n}\n";
+
+    // Replaces the previous checkpoint only once the new one is complete
+    string temporary = path + ".tmp";
+
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        file.write(text.data(), text.size());
+
+        if (!file) {
+            POLYG_LOG(WARN, "Cannot write the checkpoint " << temporary);
+            return;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        POLYG_LOG(WARN, "Cannot replace the checkpoint " << path);
+        return;
+    }
+
+    last = std::chrono::steady_clock::now();
+
+    POLYG_LOG(INFO, "Checkpoint ... " << path << " (" << state.method << ", iteration " << state.iteration << ")");
+}
+
+vector<Point> Checkpoint::pointsOf(CDT& cdt, const vector<int>& ids) {
+    vector<Point> by_id(cdt.number_of_vertices());
+    vector<Point> points;
+
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        by_id[vit->id()] = vit->point();
+    }
+
+    for (int id : ids) {
+        if (id < 0 || id >= (int)by_id.size()) {
+            throw runtime_error("checkpoint Steiner vertex out of range");
+        }
+
+        points.push_back(by_id[id]);
+    }
+
+    return points;
+}
+
+vector<int> Checkpoint::idsOf(CDT& cdt, const vector<Point>& points) {
+    vector<int> ids;
+
+    for (const Point& p : points) {
+        ids.push_back(cdt.vertex_at(p)->id());
+    }
+
+    return ids;
+}
+
+SearchState Checkpoint::restore(const char* checkpointfile, CDT& cdt) {
+    string text;
+
+    {
+        ifstream in(checkpointfile, ios::binary);
+
+        if (!in) {
+            throw runtime_error(string("cannot open the checkpoint ") + checkpointfile);
+        }
+
+        in.seekg(0, ios::end);
+        text.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0, ios::beg);
+        in.read(&text[0], text.size());
+    }
+
+    SearchState state;
+    vector<Point> points;
+    vector<std::pair<int, int>> constraints;
+    JsonCursor cursor(text.data(), text.data() + text.size());
+
+    cursor.expect('{');
+
+    if (!cursor.consume('}')) {
+        do {
+            string key = cursor.parseString();
+            cursor.expect(':');
+
+            if (key == "method") {
+                state.method = cursor.parseString();
+            } else if (key == "seed") {
+                state.seed = parseUnsigned(cursor);
+            } else if (key == "iteration") {
+                state.iteration = int(cursor.parseInteger());
+            } else if (key == "temperature") {
+                state.temperature = float(cursor.parseReal());
+            } else if (key == "rng") {
+                cursor.expect('[');
+                for (size_t i = 0; i < state.rng.size(); i++) {
+                    if (i > 0) {
+                        cursor.expect(',');
+                    }
+                    state.rng[i] = parseUnsigned(cursor);
+                }
+                cursor.expect(']');
+            } else if (key == "pheromones") {
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        state.pheromones.push_back(float(cursor.parseReal()));
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            } else if (key == "vertices") {
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        cursor.expect('[');
+                        K::FT x = cursor.parseCoordinate();
+                        cursor.expect(',');
+                        K::FT y = cursor.parseCoordinate();
+                        cursor.expect(']');
+                        points.emplace_back(x, y);
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            } else if (key == "constraints") {
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        cursor.expect('[');
+                        int first = int(cursor.parseInteger());
+                        cursor.expect(',');
+                        int second = int(cursor.parseInteger());
+                        cursor.expect(']');
+                        constraints.emplace_back(first, second);
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            } else if (key == "steiner_vertices") {
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        state.steiner_vertices.push_back(int(cursor.parseInteger()));
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            } else {
+                cursor.skipValue();
+            }
+        } while (cursor.consume(','));
+        cursor.expect('}');
+    }
+
+    //
+    // Vertices in id order (each located from the previous one), then the
+    // constrained edges between them
+    //
+    vector<Vertex_handle> vertices;
+    vertices.reserve(points.size());
+
+    Vertex_handle previous;
+
+    for (const Point& p : points) {
+        previous = cdt.insert(p, previous == Vertex_handle() ? CDT::Face_handle() : previous->face());
+        vertices.push_back(previous);
+    }
+
+    for (const auto& constraint : constraints) {
+        if (constraint.first < 0 || constraint.second < 0 || constraint.first >= (int)vertices.size() || constraint.second >= (int)vertices.size()) {
+            throw runtime_error("checkpoint constraint out of range");
+        }
+
+        cdt.insert_constraint(vertices[constraint.first], vertices[constraint.second]);
+    }
+
+    if (cdt.number_of_vertices() != points.size()) {
+        throw runtime_error("checkpoint with duplicate vertices");
+    }
+
+    return state;
+}
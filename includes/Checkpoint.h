@@ -0,0 +1,75 @@
+#pragma once
+
+// Macros for CGAL
+#include "cgal_definitions.h"
+
+// Standard C++
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Namespaces
+using namespace std;
+
+//
+// Where a long search (sa, ant) stands, besides its triangulation
+//
+struct SearchState {
+    string method;
+    uint64_t seed = 0;                 // of the run (Checkpoint::seed when saved)
+    int iteration = 0;                 // sweeps (sa) or cycles (ant) done
+    float temperature = 1;             // sa
+    vector<float> pheromones;          // ant
+    std::array<uint64_t, 4> rng = {};  // stream of the solving thread
+    vector<int> steiner_vertices;      // vertex ids of the Steiner points of the search, in order
+};
+
+//
+// Periodic checkpoints of a search: every vertex of the triangulation in id
+// order (exact "p/q" coordinates) and every constrained edge, which covers
+// the constraints POLYGON added, with the SearchState. A checkpoint is
+// written to a temporary file and renamed, so a kill leaves the previous
+// one intact. Restoring inserts the vertices in the same order (the ids,
+// hence the exported solution, match) and the constrained edges, without
+// any search: the triangulation is the constrained Delaunay one of the
+// checkpoint, which the search then continues from.
+//
+class Checkpoint {
+public:
+    // No checkpoints
+    Checkpoint() {}
+
+    // Written to path every interval seconds (at the end of a sweep or cycle)
+    Checkpoint(const string& path, double interval_seconds);
+
+    bool enabled() const {
+        return !path.empty();
+    }
+
+    // The interval has elapsed since the last save
+    bool due() const;
+
+    void save(CDT& cdt, const SearchState& state);
+
+    // Builds the triangulation of a checkpoint into an empty cdt; throws
+    // std::runtime_error if the file is unreadable
+    static SearchState restore(const char* checkpointfile, CDT& cdt);
+
+    // Points of vertex ids of cdt, and the reverse (Steiner points of a search)
+    static vector<Point> pointsOf(CDT& cdt, const vector<int>& ids);
+    static vector<int> idsOf(CDT& cdt, const vector<Point>& points);
+
+    // State the search continues from, set when the run was restored
+    std::optional<SearchState> resume;
+
+    // Seed of the run, recorded with every state
+    uint64_t seed = 0;
+
+private:
+    string path;
+    double interval = 0;
+    std::chrono::steady_clock::time_point last;
+};
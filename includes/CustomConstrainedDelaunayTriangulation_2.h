@@ -2,6 +2,17 @@
 
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Profiler.h"
+#include "TriangulationChangeLog.h"
+#include "obtuse_predicates.h"
+
 template <class Gt, class Tds = CGAL::Default, class Itag = CGAL::Default>
 class CustomConstrainedDelaunayTriangulation_2 : public CGAL::Constrained_Delaunay_triangulation_2<Gt, Tds, Itag> {
 public:
@@ -12,6 +23,14 @@ public:
     using typename Base::Vertex_handle;
     using typename Base::Locate_type;
 
+    typedef typename Base::Triangulation_data_structure Triangulation_data_structure;
+    typedef TriangulationChangeLog<Triangulation_data_structure> Change_log;
+    typedef typename Change_log::FaceRecord FaceRecord;
+    typedef typename Change_log::FaceState FaceState;
+    typedef typename Change_log::VertexState VertexState;
+    typedef typename Triangulation_data_structure::Face Face;
+    typedef typename Triangulation_data_structure::Vertex Vertex;
+
 
 
     // Constructors
@@ -19,24 +38,732 @@ public:
 
     }
 
-    CustomConstrainedDelaunayTriangulation_2(typename Base::List_constraints& lc, const Gt& gt = Gt()) : Base(lc, gt) {}
+    CustomConstrainedDelaunayTriangulation_2(typename Base::List_constraints& lc, const Gt& gt = Gt()) : Base(lc, gt) {
+        obtuse_faces_valid = false;
+    }
 
 
 
     template <class InputIterator>
-    CustomConstrainedDelaunayTriangulation_2(InputIterator it, InputIterator last, const Gt& gt = Gt()) : Base(it, last, gt) {}
+    CustomConstrainedDelaunayTriangulation_2(InputIterator it, InputIterator last, const Gt& gt = Gt()) : Base(it, last, gt) {
+        obtuse_faces_valid = false;
+    }
+
+    //
+    // Copies keep the vertex ids, the constraints and the face flags. The
+    // observer, the transactions and the indexes keyed by the handles of the
+    // source are not copied (the indexes are rebuilt on first use).
+    //
+    CustomConstrainedDelaunayTriangulation_2(const CustomConstrainedDelaunayTriangulation_2& other) : Base(other) {
+        copy_counts(other);
+    }
+
+    CustomConstrainedDelaunayTriangulation_2& operator=(const CustomConstrainedDelaunayTriangulation_2& other) {
+        CGAL_precondition(!in_transaction());
+
+        if (this != &other) {
+            Base::operator=(other);
+            copy_counts(other);
+        }
+
+        return *this;
+    }
+
+    // Insert methods (flips restore the Delaunay property)
+
+    Vertex_handle insert(const Point& a, Face_handle start = Face_handle()) {
+        ChangeScope scope(*this);
+        return Base::insert(a, start);
+    }
+
+    Vertex_handle insert(const Point& a, Locate_type lt, Face_handle loc, int li) {
+        ChangeScope scope(*this);
+        return Base::insert(a, lt, loc, li);
+    }
 
     // New insert method without flips
 
     Vertex_handle insert_no_flip(const Point& a, Face_handle start = Face_handle()) {
+        ChangeScope scope(*this);
         // Call Ctr::insert without flip_around
         Vertex_handle va = this->Base::Ctr::insert(a, start); // Directly call Ctr::insert from the base
         return va;
     }
 
     Vertex_handle insert_no_flip(const Point& a, Locate_type lt, Face_handle loc, int li) {
+        ChangeScope scope(*this);
         Vertex_handle va = this->Base::Ctr::insert(a, lt, loc, li); // Directly call Ctr::insert from the base
         return va;
     }
-};
 
+    // Constraints
+
+    void insert_constraint(const Point& a, const Point& b) {
+        ChangeScope scope(*this);
+        Base::insert_constraint(a, b);
+    }
+
+    void insert_constraint(Vertex_handle va, Vertex_handle vb) {
+        ChangeScope scope(*this);
+        Base::insert_constraint(va, vb);
+    }
+
+    //
+    // Number of obtuse finite faces. Maintained by the methods above from the
+    // faces each operation created or destroyed, after a full scan the first
+    // time. Only valid while every mutation goes through this wrapper: a
+    // change through Base:: or a free CGAL function leaves it stale, and
+    // nothing detects that.
+    //
+    int number_of_obtuse_faces() {
+        if (!obtuse_faces_valid) {
+            obtuse_faces = 0;
+
+            for (auto fit = this->finite_faces_begin(); fit != this->finite_faces_end(); ++fit) {
+                obtuse_faces += is_obtuse_face(fit);
+            }
+
+            obtuse_faces_valid = true;
+        }
+
+        return obtuse_faces;
+    }
+
+    // Cached obtuse test of a face (infinite faces are never obtuse)
+    template <class FaceRef>
+    int is_obtuse_face(FaceRef f) const {
+        if (f->obtuse_flag() < 0) {
+            f->set_obtuse_flag(is_obtuse_triangle(f->vertex(0), f->vertex(1), f->vertex(2)));
+        }
+
+        return f->obtuse_flag();
+    }
+
+    //
+    // Constrained edges, indexed by their vertices so the test is O(1), and
+    // vertices indexed by their (exact) point for the callers that only have
+    // coordinates. Both are built on first use, then kept in sync by the
+    // methods above and by the rollback.
+    //
+    bool is_constrained_edge(Vertex_handle va, Vertex_handle vb) {
+        if (!constrained_edges_valid) {
+            constrained_edges.clear();
+
+            for (auto eit = this->finite_edges_begin(); eit != this->finite_edges_end(); ++eit) {
+                add_constrained_edge(&*eit->first, eit->second);
+            }
+
+            constrained_edges_valid = true;
+        }
+
+        return constrained_edges.count(edge_key(&*va, &*vb)) != 0;
+    }
+
+    bool is_constrained_edge(const Point& a, const Point& b) {
+        Vertex_handle va = vertex_at(a);
+        Vertex_handle vb = vertex_at(b);
+
+        return va != Vertex_handle() && vb != Vertex_handle() && is_constrained_edge(va, vb);
+    }
+
+    // Vertex at p (the default handle if there is none)
+    Vertex_handle vertex_at(const Point& p) {
+        if (!vertices_by_point_valid) {
+            vertices_by_point.clear();
+
+            for (auto vit = this->finite_vertices_begin(); vit != this->finite_vertices_end(); ++vit) {
+                vertices_by_point[vit->point()] = vit;
+            }
+
+            vertices_by_point_valid = true;
+        }
+
+        auto it = vertices_by_point.find(p);
+
+        return it == vertices_by_point.end() ? Vertex_handle() : it->second;
+    }
+
+    //
+    // Observer of the faces each operation created or modified, e.g. to keep
+    // a worklist of obtuse faces. Inside a transaction the faces are held
+    // back until the commit (a rollback drops them).
+    //
+    void set_face_observer(std::function<void(Face_handle)> observer) {
+        face_observer = std::move(observer);
+        observed_in_transaction.clear();
+    }
+
+    //
+    // Transactions: every face and vertex change made by the methods above
+    // between begin_transaction() and rollback() is undone by the rollback in
+    // O(changed faces), which replaces trial copies of the whole triangulation.
+    // Requires a 2D triangulation. Handles of faces the transaction destroyed
+    // (e.g. crossed by a new constraint) are not valid after the rollback;
+    // faces that were only modified keep their handles.
+    //
+    void begin_transaction() {
+        CGAL_precondition(!in_transaction() && this->dimension() == 2);
+
+        saved_obtuse_faces = obtuse_faces;
+        saved_obtuse_faces_valid = obtuse_faces_valid;
+        saved_next_vertex_id = next_vertex_id;
+        change_log.begin_journal();
+    }
+
+    bool in_transaction() const {
+        return change_log.is_journaling();
+    }
+
+    // Keep the changes
+    void commit() {
+        change_log.end_journal();
+
+        if (face_observer) {
+            Face_handle f;
+
+            for (const auto& v : observed_in_transaction) {
+                if (this->is_face(v[0], v[1], v[2], f)) {
+                    face_observer(f);
+                }
+            }
+        }
+
+        observed_in_transaction.clear();
+    }
+
+    // Undo the changes
+    void rollback() {
+        CGAL_precondition(in_transaction() && Change_log::active() == nullptr);
+
+        change_log.end_journal();
+        observed_in_transaction.clear();
+
+        POLYG_COUNT(ROLLBACKS);
+
+        std::vector<FaceState>& faces = change_log.journal_faces;
+        std::vector<VertexState>& vertices = change_log.journal_vertices;
+
+        // Handles of what exists now (the triangulation is still valid here)
+        for (FaceState& r : faces) {
+            if (r.alive) {
+                r.handle = handle_of(r.face);
+            }
+        }
+
+        for (VertexState& r : vertices) {
+            if (r.alive) {
+                r.handle = handle_of(r.vertex);
+            }
+        }
+
+        // Forget the indexed edges and points of what is about to change
+        for (FaceState& r : faces) {
+            if (r.alive && constrained_edges_valid) {
+                for (int i = 0; i < 3; i++) {
+                    constrained_edges.erase(edge_key(&*r.handle->vertex(this->ccw(i)), &*r.handle->vertex(this->cw(i))));
+                }
+            }
+        }
+
+        for (VertexState& r : vertices) {
+            if (r.alive && vertices_by_point_valid) {
+                vertices_by_point.erase(r.handle->point());
+            }
+        }
+
+        // Remove what the transaction created
+        for (FaceState& r : faces) {
+            if (r.created && r.alive) {
+                this->tds().delete_face(r.handle);
+            }
+        }
+
+        for (VertexState& r : vertices) {
+            if (r.created && r.alive) {
+                this->tds().delete_vertex(r.handle);
+            }
+        }
+
+        // Bring back what it destroyed
+        std::unordered_map<const Face*, Face_handle> faces_back;
+        std::unordered_map<const Vertex*, Vertex_handle> vertices_back;
+
+        for (FaceState& r : faces) {
+            if (!r.created && !r.alive) {
+                r.handle = this->tds().create_face();
+                faces_back[r.face] = r.handle;
+            }
+        }
+
+        for (VertexState& r : vertices) {
+            if (!r.created && !r.alive) {
+                r.handle = this->tds().create_vertex();
+                vertices_back[r.vertex] = r.handle;
+            }
+        }
+
+        auto face_back = [&faces_back](Face_handle f) {
+            auto it = faces_back.find(&*f);
+            return it == faces_back.end() ? f : it->second;
+        };
+
+        auto vertex_back = [&vertices_back](Vertex_handle v) {
+            auto it = vertices_back.find(&*v);
+            return it == vertices_back.end() ? v : it->second;
+        };
+
+        // Restore the state they had when the transaction began
+        for (FaceState& r : faces) {
+            if (r.created) {
+                continue;
+            }
+
+            r.handle->set_vertices(vertex_back(r.vertices[0]), vertex_back(r.vertices[1]), vertex_back(r.vertices[2]));
+            r.handle->set_neighbors(face_back(r.neighbors[0]), face_back(r.neighbors[1]), face_back(r.neighbors[2]));
+            r.handle->set_constraints(r.constrained[0], r.constrained[1], r.constrained[2]);
+            r.handle->set_obtuse_flag(r.obtuse);
+            r.handle->set_stamp(modifications + 1);
+        }
+
+        modifications++;
+
+        for (VertexState& r : vertices) {
+            if (r.created) {
+                continue;
+            }
+
+            r.handle->set_point(r.point);
+            r.handle->set_face(face_back(r.face));
+            r.handle->set_id(r.id);
+
+            if (vertices_by_point_valid) {
+                vertices_by_point[r.point] = r.handle;
+            }
+        }
+
+        if (constrained_edges_valid) {
+            for (FaceState& r : faces) {
+                if (!r.created) {
+                    for (int i = 0; i < 3; i++) {
+                        add_constrained_edge(&*r.handle, i);
+                    }
+                }
+            }
+        }
+
+        faces.clear();
+        vertices.clear();
+
+        obtuse_faces = saved_obtuse_faces;
+        obtuse_faces_valid = saved_obtuse_faces_valid;
+        next_vertex_id = saved_next_vertex_id;
+    }
+
+    //
+    // What-if insertion: change of the number of obtuse faces if p were
+    // inserted (with or without flips). The faces within `rings` steps of the
+    // face containing p are copied into a standalone patch whose edges are
+    // all constrained, except the interior ones that are free here, so the
+    // border is frozen and the cost depends on the patch size only. Points on
+    // the border of the patch (or outside the hull) are tried in a transaction.
+    //
+    int obtuse_delta_of_insertion(const Point& p, bool flips, Face_handle start = Face_handle(), int rings = 2) {
+        Locate_type lt;
+        int li;
+        Face_handle loc = this->locate(p, lt, li, start);
+        int delta = 0;
+
+        if (patch_obtuse_delta(p, flips, lt, loc, li, rings, delta)) {
+            return delta;
+        }
+
+        return obtuse_delta_in_transaction(p, flips, loc);
+    }
+
+    //
+    // The patch part of obtuse_delta_of_insertion(), for a point the caller
+    // already located. It only reads this triangulation, so several threads
+    // may run it at once as long as nothing modifies the triangulation
+    // meanwhile (locate() may not run concurrently: it draws random numbers)
+    // and make_patch_exact() ran first. Returns false if the point needs the
+    // transaction.
+    //
+    bool patch_obtuse_delta(const Point& p, bool flips, Locate_type lt, Face_handle loc, int li, int rings, int& delta) const {
+        if (lt == Base::VERTEX) {
+            delta = 0; // nothing to insert
+            return true;
+        }
+
+        if ((lt != Base::FACE && lt != Base::EDGE) || this->is_infinite(loc)) {
+            return false;
+        }
+
+        std::vector<Face_handle> patch_faces;
+        std::unordered_set<const Face*> in_patch;
+
+        k_ring(loc, rings, patch_faces, in_patch);
+
+        if (lt == Base::EDGE && in_patch.count(&*loc->neighbor(li)) == 0) {
+            return false;
+        }
+
+        profiler::PrimitiveScope copy_scope(profiler::CDT_COPY);
+        POLYG_COUNT(CDT_COPIES);
+
+        // Standalone copy: vertices, then every edge as a constraint
+        CustomConstrainedDelaunayTriangulation_2 patch(this->geom_traits());
+        std::unordered_map<const Vertex*, Vertex_handle> patch_vertices;
+
+        for (Face_handle f : patch_faces) {
+            for (int i = 0; i < 3; i++) {
+                Vertex_handle v = f->vertex(i);
+
+                if (patch_vertices.count(&*v) == 0) {
+                    patch_vertices[&*v] = patch.insert(v->point());
+                }
+            }
+        }
+
+        for (Face_handle f : patch_faces) {
+            for (int i = 0; i < 3; i++) {
+                Face_handle n = f->neighbor(i);
+
+                if (in_patch.count(&*n) == 0 || &*f < &*n) {
+                    patch.insert_constraint(patch_vertices[&*f->vertex(this->ccw(i))], patch_vertices[&*f->vertex(this->cw(i))]);
+                }
+            }
+        }
+
+        // Free the interior edges that are not constrained here
+        for (Face_handle f : patch_faces) {
+            for (int i = 0; i < 3; i++) {
+                Face_handle n = f->neighbor(i);
+
+                if (in_patch.count(&*n) != 0 && &*f < &*n && !f->is_constrained(i)) {
+                    Face_handle pf;
+                    int pi;
+
+                    if (patch.is_edge(patch_vertices[&*f->vertex(this->ccw(i))], patch_vertices[&*f->vertex(this->cw(i))], pf, pi)) {
+                        patch.Base::Ctr::remove_constrained_edge(pf, pi);
+                    }
+                }
+            }
+        }
+
+        int before = patch.number_of_obtuse_faces();
+
+        if (flips) {
+            patch.insert(p);
+        } else {
+            patch.insert_no_flip(p);
+        }
+
+        delta = patch.number_of_obtuse_faces() - before;
+        return true;
+    }
+
+    //
+    // Computes the exact values of p and of the points of its patch, to run
+    // (serially) before patch_obtuse_delta() goes to another thread. The
+    // threads share the lazy values of these points, and a filter failure
+    // would otherwise compute them from several threads at once, which the
+    // lazy kernel does not allow. The threads then only read them.
+    //
+    void make_patch_exact(const Point& p, Face_handle loc, int rings) const {
+        CGAL::exact(p);
+
+        if (loc == Face_handle() || this->is_infinite(loc)) {
+            return;
+        }
+
+        std::vector<Face_handle> patch_faces;
+        std::unordered_set<const Face*> in_patch;
+
+        k_ring(loc, rings, patch_faces, in_patch);
+
+        for (Face_handle f : patch_faces) {
+            for (int i = 0; i < 3; i++) {
+                CGAL::exact(f->vertex(i)->point());
+            }
+        }
+    }
+
+    //
+    // Modification stamps: every operation (and rollback) increments the
+    // count and stamps the faces it created or modified with it. A result
+    // computed from the faces around f at stamp t is still valid while
+    // patch_stamp(f, rings) <= t.
+    //
+    unsigned long modification_stamp() const {
+        return modifications;
+    }
+
+    unsigned long patch_stamp(Face_handle f, int rings) const {
+        std::vector<Face_handle> faces;
+        std::unordered_set<const Face*> in_ring;
+        unsigned long stamp = 0;
+
+        k_ring(f, rings, faces, in_ring);
+
+        for (Face_handle g : faces) {
+            stamp = std::max(stamp, g->stamp());
+        }
+
+        return stamp;
+    }
+
+    // Finite faces within `rings` steps of f (f first, then ring by ring)
+    void k_ring(Face_handle f, int rings, std::vector<Face_handle>& faces, std::unordered_set<const Face*>& in_ring) const {
+        faces.push_back(f);
+        in_ring.insert(&*f);
+
+        std::size_t ring_begin = faces.size() - 1;
+
+        for (int ring = 0; ring < rings; ring++) {
+            std::size_t ring_end = faces.size();
+
+            for (std::size_t k = ring_begin; k < ring_end; k++) {
+                for (int i = 0; i < 3; i++) {
+                    Face_handle n = faces[k]->neighbor(i);
+
+                    if (!this->is_infinite(n) && in_ring.insert(&*n).second) {
+                        faces.push_back(n);
+                    }
+                }
+            }
+
+            ring_begin = ring_end;
+        }
+    }
+
+private:
+    int obtuse_faces = 0;
+    bool obtuse_faces_valid = true;
+    int saved_obtuse_faces = 0;
+    bool saved_obtuse_faces_valid = true;
+    int next_vertex_id = 0;
+    int saved_next_vertex_id = 0;
+    unsigned long modifications = 0;
+    Change_log change_log;
+
+    std::function<void(Face_handle)> face_observer;
+    std::vector<std::array<Vertex_handle, 3>> observed_in_transaction;
+
+    struct Vertex_pair_hash {
+        std::size_t operator()(const std::pair<const Vertex*, const Vertex*>& e) const {
+            return std::hash<const Vertex*>()(e.first) * 31 + std::hash<const Vertex*>()(e.second);
+        }
+    };
+
+    // Hash of the exact coordinates, so that equal points always collide. A
+    // coordinate whose interval is a single double is that double, which
+    // covers the input and most Steiner points without evaluating their
+    // constructions; only the others are made exact.
+    struct Point_hash {
+        template <class NT>
+        static std::size_t coordinate_hash(const NT& v) {
+            const auto& interval = v.approx();
+            return std::hash<double>()(interval.is_point() ? interval.inf() : CGAL::to_double(CGAL::exact(v)));
+        }
+
+        std::size_t operator()(const Point& p) const {
+            std::size_t hx = coordinate_hash(p.x());
+            std::size_t hy = coordinate_hash(p.y());
+            return hx ^ (hy + 0x9e3779b9 + (hx << 6) + (hx >> 2));
+        }
+    };
+
+    std::unordered_set<std::pair<const Vertex*, const Vertex*>, Vertex_pair_hash> constrained_edges;
+    bool constrained_edges_valid = false;
+    std::unordered_map<Point, Vertex_handle, Point_hash> vertices_by_point;
+    bool vertices_by_point_valid = false;
+
+    void copy_counts(const CustomConstrainedDelaunayTriangulation_2& other) {
+        CGAL_precondition(!other.in_transaction());
+
+        obtuse_faces = other.obtuse_faces;
+        obtuse_faces_valid = other.obtuse_faces_valid;
+        next_vertex_id = other.next_vertex_id;
+        modifications = std::max(modifications, other.modifications) + 1;
+
+        constrained_edges.clear();
+        constrained_edges_valid = false;
+        vertices_by_point.clear();
+        vertices_by_point_valid = false;
+    }
+
+    static std::pair<const Vertex*, const Vertex*> edge_key(const Vertex* a, const Vertex* b) {
+        return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+    }
+
+    void add_constrained_edge(const Face* f, int i) {
+        if (f->is_constrained(i)) {
+            constrained_edges.insert(edge_key(&*f->vertex(this->ccw(i)), &*f->vertex(this->cw(i))));
+        }
+    }
+
+    // Fallback of obtuse_delta_of_insertion(): insert, count and roll back
+    int obtuse_delta_in_transaction(const Point& p, bool flips, Face_handle start) {
+        int before = number_of_obtuse_faces();
+
+        begin_transaction();
+
+        if (flips) {
+            insert(p, start);
+        } else {
+            insert_no_flip(p, start);
+        }
+
+        int after = number_of_obtuse_faces();
+
+        rollback();
+
+        return after - before;
+    }
+
+    // Handle of a face of the triangulation, found through its neighbor
+    static Face_handle handle_of(Face* f) {
+        Face_handle n = f->neighbor(0);
+
+        for (int j = 0; j < 3; j++) {
+            if (&*(n->neighbor(j)) == f) {
+                return n->neighbor(j);
+            }
+        }
+
+        CGAL_assertion(false);
+        return Face_handle();
+    }
+
+    // Handle of a vertex of the triangulation, found through its face
+    static Vertex_handle handle_of(Vertex* v) {
+        Face_handle f = v->face();
+
+        for (int j = 0; j < 3; j++) {
+            if (&*(f->vertex(j)) == v) {
+                return f->vertex(j);
+            }
+        }
+
+        CGAL_assertion(false);
+        return Vertex_handle();
+    }
+
+    //
+    // Activates the change log for the duration of one modifying operation.
+    // Nested operations (insert_constraint inserts its end points) are part of
+    // the outermost one.
+    //
+    class ChangeScope {
+    public:
+        ChangeScope(CustomConstrainedDelaunayTriangulation_2& cdt) : cdt(cdt), outer(Change_log::active() == &cdt.change_log) {
+            if (!outer) {
+                dimension = cdt.dimension();
+                previous = Change_log::active();
+                cdt.change_log.begin();
+                Change_log::active() = &cdt.change_log;
+            }
+        }
+
+        ~ChangeScope() {
+            if (!outer) {
+                Change_log::active() = previous;
+                cdt.apply_changes(dimension);
+            }
+        }
+
+    private:
+        CustomConstrainedDelaunayTriangulation_2& cdt;
+        bool outer;
+        int dimension = 0;
+        Change_log* previous = nullptr;
+    };
+
+    int is_obtuse_triangle(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2) const {
+        if (this->is_infinite(v0) || this->is_infinite(v1) || this->is_infinite(v2)) {
+            return 0;
+        }
+
+        const Point& a = v0->point();
+        const Point& b = v1->point();
+        const Point& c = v2->point();
+
+        return obtuse_predicates::obtuse_vertex(a, b, c) >= 0 ? 1 : 0;
+    }
+
+    // Update the obtuse counter and the indexes with the faces the last operation destroyed and created
+    void apply_changes(int dimension_before) {
+        for (Vertex* v : change_log.vertices) {
+            v->set_id(next_vertex_id++);
+        }
+
+        modifications++;
+
+        for (const FaceRecord& r : change_log.faces) {
+            if (r.face != nullptr) {
+                r.face->set_stamp(modifications);
+            }
+        }
+
+        if (dimension_before < 2 || this->dimension() < 2) {
+            obtuse_faces_valid = false;
+            constrained_edges_valid = false;
+            vertices_by_point_valid = false;
+        }
+
+        if (obtuse_faces_valid) {
+            for (const FaceRecord& r : change_log.faces) {
+                if (!r.created) {
+                    obtuse_faces -= r.obtuse >= 0 ? r.obtuse : is_obtuse_triangle(r.vertices[0], r.vertices[1], r.vertices[2]);
+                }
+
+                if (r.face != nullptr) {
+                    obtuse_faces += is_obtuse_face(r.face);
+                }
+            }
+        }
+
+        if (constrained_edges_valid) {
+            // An edge that survives has a touched face on one side at least
+            for (const FaceRecord& r : change_log.faces) {
+                if (!r.created) {
+                    for (int i = 0; i < 3; i++) {
+                        constrained_edges.erase(edge_key(&*r.vertices[this->ccw(i)], &*r.vertices[this->cw(i)]));
+                    }
+                }
+            }
+
+            for (const FaceRecord& r : change_log.faces) {
+                if (r.face != nullptr) {
+                    for (int i = 0; i < 3; i++) {
+                        add_constrained_edge(r.face, i);
+                    }
+                }
+            }
+        }
+
+        if (face_observer && this->dimension() == 2) {
+            for (const FaceRecord& r : change_log.faces) {
+                if (r.face == nullptr) {
+                    continue;
+                }
+
+                if (in_transaction()) {
+                    observed_in_transaction.push_back({r.face->vertex(0), r.face->vertex(1), r.face->vertex(2)});
+                } else {
+                    face_observer(handle_of(r.face));
+                }
+            }
+        }
+
+        if (vertices_by_point_valid) {
+            if (change_log.vertices_destroyed) {
+                vertices_by_point_valid = false;
+            } else {
+                for (Vertex* v : change_log.vertices) {
+                    vertices_by_point[v->point()] = handle_of(v);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <CGAL/Constrained_triangulation_face_base_2.h>
+
+#include "TriangulationChangeLog.h"
+
+//
+// Constrained face base that reports its changes (vertices, neighbors,
+// constraint flags) to the active TriangulationChangeLog, caches whether
+// the face is obtuse and records when it last changed.
+//
+template <class Gt, class Fb = CGAL::Constrained_triangulation_face_base_2<Gt>>
+class CustomConstrainedTriangulationFaceBase_2 : public Fb {
+public:
+    typedef typename Fb::Vertex_handle Vertex_handle;
+    typedef typename Fb::Face_handle Face_handle;
+    typedef typename Fb::Triangulation_data_structure Tds;
+
+    template <typename TDS2>
+    struct Rebind_TDS {
+        typedef typename Fb::template Rebind_TDS<TDS2>::Other Fb2;
+        typedef CustomConstrainedTriangulationFaceBase_2<Gt, Fb2> Other;
+    };
+
+    // Bookkeeping of the change log (see TriangulationChangeLog)
+    unsigned long change_epoch = 0;
+    int change_slot = -1;
+    unsigned long journal_epoch = 0;
+    int journal_slot = -1;
+
+    CustomConstrainedTriangulationFaceBase_2() : Fb() {
+        created();
+    }
+
+    CustomConstrainedTriangulationFaceBase_2(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2) : Fb(v0, v1, v2) {
+        created();
+    }
+
+    CustomConstrainedTriangulationFaceBase_2(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2, Face_handle n0, Face_handle n1, Face_handle n2) : Fb(v0, v1, v2, n0, n1, n2) {
+        created();
+    }
+
+    CustomConstrainedTriangulationFaceBase_2(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2, Face_handle n0, Face_handle n1, Face_handle n2, bool c0, bool c1, bool c2)
+        : Fb(v0, v1, v2, n0, n1, n2, c0, c1, c2) {
+        created();
+    }
+
+    CustomConstrainedTriangulationFaceBase_2(const CustomConstrainedTriangulationFaceBase_2& other) : Fb(other), obtuse(other.obtuse) {
+        created();
+    }
+
+    CustomConstrainedTriangulationFaceBase_2& operator=(const CustomConstrainedTriangulationFaceBase_2& other) {
+        vertices_changed();
+        Fb::operator=(other);
+        obtuse = other.obtuse;
+        return *this;
+    }
+
+    ~CustomConstrainedTriangulationFaceBase_2() {
+        if (Change_log* log = Change_log::active()) {
+            log->face_destroyed(self());
+        }
+    }
+
+    // Modifiers (hide the ones of the base to catch every change)
+
+    void set_vertex(int i, Vertex_handle v) {
+        vertices_changed();
+        Fb::set_vertex(i, v);
+    }
+
+    void set_vertices() {
+        vertices_changed();
+        Fb::set_vertices();
+    }
+
+    void set_vertices(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2) {
+        vertices_changed();
+        Fb::set_vertices(v0, v1, v2);
+    }
+
+    void set_neighbor(int i, Face_handle n) {
+        changed();
+        Fb::set_neighbor(i, n);
+    }
+
+    void set_neighbors() {
+        changed();
+        Fb::set_neighbors();
+    }
+
+    void set_neighbors(Face_handle n0, Face_handle n1, Face_handle n2) {
+        changed();
+        Fb::set_neighbors(n0, n1, n2);
+    }
+
+    void set_constraint(int i, bool b) {
+        changed();
+        Fb::set_constraint(i, b);
+    }
+
+    void set_constraints(bool c0, bool c1, bool c2) {
+        changed();
+        Fb::set_constraints(c0, c1, c2);
+    }
+
+    void reorient() {
+        changed();
+        Fb::reorient();
+    }
+
+    void ccw_permute() {
+        changed();
+        Fb::ccw_permute();
+    }
+
+    void cw_permute() {
+        changed();
+        Fb::cw_permute();
+    }
+
+    // Obtuse cache: -1 unknown, 0 not obtuse (or infinite), 1 obtuse
+    int obtuse_flag() const {
+        return obtuse;
+    }
+
+    void set_obtuse_flag(int flag) {
+        obtuse = flag;
+    }
+
+    // Modification count of the triangulation when the face last changed
+    unsigned long stamp() const {
+        return modification_stamp;
+    }
+
+    void set_stamp(unsigned long s) {
+        modification_stamp = s;
+    }
+
+private:
+    typedef TriangulationChangeLog<Tds> Change_log;
+
+    int obtuse = -1;
+    unsigned long modification_stamp = 0;
+
+    auto self() {
+        return static_cast<typename Tds::Face*>(this);
+    }
+
+    void created() {
+        if (Change_log* log = Change_log::active()) {
+            log->face_created(self());
+        }
+    }
+
+    void changed() {
+        if (Change_log* log = Change_log::active()) {
+            log->face_changed(self());
+        }
+    }
+
+    void vertices_changed() {
+        changed();
+        obtuse = -1;
+    }
+};
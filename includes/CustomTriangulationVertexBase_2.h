@@ -0,0 +1,103 @@
+#pragma once
+
+#include <CGAL/Triangulation_vertex_base_2.h>
+
+#include "TriangulationChangeLog.h"
+
+//
+// Vertex base that reports its changes (incident face, point) to the active
+// TriangulationChangeLog, so that transactions can restore them, and carries
+// the id the triangulation assigns in insertion order.
+//
+template <class Gt, class Vb = CGAL::Triangulation_vertex_base_2<Gt>>
+class CustomTriangulationVertexBase_2 : public Vb {
+public:
+    typedef typename Vb::Face_handle Face_handle;
+    typedef typename Vb::Point Point;
+    typedef typename Vb::Triangulation_data_structure Tds;
+
+    template <typename TDS2>
+    struct Rebind_TDS {
+        typedef typename Vb::template Rebind_TDS<TDS2>::Other Vb2;
+        typedef CustomTriangulationVertexBase_2<Gt, Vb2> Other;
+    };
+
+    // Bookkeeping of the change log (see TriangulationChangeLog)
+    unsigned long journal_epoch = 0;
+    int journal_slot = -1;
+
+    CustomTriangulationVertexBase_2() : Vb() {
+        created();
+    }
+
+    CustomTriangulationVertexBase_2(const Point& p) : Vb(p) {
+        created();
+    }
+
+    CustomTriangulationVertexBase_2(const Point& p, Face_handle f) : Vb(p, f) {
+        created();
+    }
+
+    CustomTriangulationVertexBase_2(Face_handle f) : Vb(f) {
+        created();
+    }
+
+    CustomTriangulationVertexBase_2(const CustomTriangulationVertexBase_2& other) : Vb(other), vertex_id(other.vertex_id) {
+        created();
+    }
+
+    CustomTriangulationVertexBase_2& operator=(const CustomTriangulationVertexBase_2& other) {
+        changed();
+        Vb::operator=(other);
+        vertex_id = other.vertex_id;
+        return *this;
+    }
+
+    ~CustomTriangulationVertexBase_2() {
+        if (Change_log* log = Change_log::active()) {
+            log->vertex_destroyed(self());
+        }
+    }
+
+    // Modifiers (hide the ones of the base to catch every change)
+
+    void set_face(Face_handle f) {
+        changed();
+        Vb::set_face(f);
+    }
+
+    void set_point(const Point& p) {
+        changed();
+        Vb::set_point(p);
+    }
+
+    // Id: input points first, then Steiner points (-1 for the infinite vertex)
+    int id() const {
+        return vertex_id;
+    }
+
+    void set_id(int id) {
+        vertex_id = id;
+    }
+
+private:
+    typedef TriangulationChangeLog<Tds> Change_log;
+
+    int vertex_id = -1;
+
+    auto self() {
+        return static_cast<typename Tds::Vertex*>(this);
+    }
+
+    void created() {
+        if (Change_log* log = Change_log::active()) {
+            log->vertex_created(self());
+        }
+    }
+
+    void changed() {
+        if (Change_log* log = Change_log::active()) {
+            log->vertex_changed(self());
+        }
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <vector>
+
+//
+// Anytime mode: a wall-clock budget for the search. The engines poll
+// expired() between moves (never inside a transaction), so they stop with a
+// valid triangulation, and return the best one they kept (BestSolution).
+// cancel() ends one search from any thread; cancelAll() ends all of them and
+// is safe in a signal handler. The clock is the coarse monotonic one: a poll
+// is a few nanoseconds, at the resolution of the scheduler tick.
+//
+class Deadline {
+public:
+    // No budget: only a cancellation stops the search
+    Deadline() {}
+
+    // Budget in seconds from now (none if seconds <= 0)
+    explicit Deadline(double seconds) {
+        if (seconds > 0) {
+            end = now() + (int64_t)(seconds * 1e9);
+        }
+    }
+
+    bool budgeted() const {
+        return end != 0;
+    }
+
+    bool expired() const {
+        return cancelled.load(std::memory_order_relaxed) || all_cancelled.load(std::memory_order_relaxed) || (end != 0 && now() >= end);
+    }
+
+    // Seconds left, 0 once expired; infinity without a budget
+    double remaining() const {
+        if (end == 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        int64_t left = end - now();
+
+        return left > 0 ? left * 1e-9 : 0;
+    }
+
+    void cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    static void cancelAll() {
+        all_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    static bool allCancelled() {
+        return all_cancelled.load(std::memory_order_relaxed);
+    }
+
+private:
+    static int64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    int64_t end = 0;
+    std::atomic<bool> cancelled{false};
+
+    static inline std::atomic<bool> all_cancelled{false};
+};
+
+//
+// Lowest-energy state seen by a search: a copy of the triangulation and its
+// Steiner points, taken at the end of a sweep (or cycle) that improved on
+// it. Kept under a budget only, where the search may stop after uphill
+// moves; restore() puts it back if the search ended worse.
+//
+// restore() assigns the copy to cdt: every Vertex_handle and Face_handle
+// into cdt taken before is then invalid, look them up again (vertex_at,
+// locate) in the restored triangulation.
+//
+template <class Triangulation, class Point>
+class BestSolution {
+public:
+    explicit BestSolution(bool enabled) : enabled(enabled) {}
+
+    void offer(float energy, const Triangulation& cdt, const std::vector<Point>& steinerPoints) {
+        if (enabled && energy < best_energy) {
+            best_energy = energy;
+            best_cdt = cdt;
+            best_points = steinerPoints;
+        }
+    }
+
+    // Returns true if the kept state replaced the current one (and
+    // invalidated every handle into cdt)
+    bool restore(float energy, Triangulation& cdt, std::vector<Point>& steinerPoints) {
+        if (!enabled || best_energy >= energy) {
+            return false;
+        }
+
+        cdt = best_cdt;
+        steinerPoints = best_points;
+
+        return true;
+    }
+
+    float energy() const {
+        return best_energy;
+    }
+
+private:
+    bool enabled;
+    float best_energy = std::numeric_limits<float>::infinity();
+    Triangulation best_cdt;
+    std::vector<Point> best_points;
+};
@@ -1,106 +1,305 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
 #include <vector>
 
+#include "BinaryFormat.h"
+#include "JsonCursor.h"
 #include "JsonLoader.h"
+#include "Log.h"
 
 // Namespaces
 using namespace std;
 
-void JsonLoader::load(const char* inputfile) {
+void JsonLoader::load(const char* inputfile, bool instance_only) {
+    this->instance_only = instance_only;
+    method.clear();
+
+    if (BinaryFile::isBinary(inputfile)) {
+        loadBinary(inputfile);
+        return;
+    }
+
+    string text;
+
+    {
+        ifstream in(inputfile, ios::binary);
+
+        if (!in) {
+            throw runtime_error(string("Error reading JSON file: ") + inputfile + ": cannot open file");
+        }
+
+        in.seekg(0, ios::end);
+        text.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0, ios::beg);
+        in.read(&text[0], text.size());
+    }
+
+    vector<string> keys;
+
+    parameters.clear();
+    points.clear();
+    region_boundary.clear();
+    additional_constraints.clear();
+
     try {
-        boost::property_tree::read_json(inputfile, pt);
+        JsonCursor cursor(text.data(), text.data() + text.size());
+
+        // The first coordinate array is kept until the second one arrives,
+        // then the points are built in place
+        vector<K::FT> pending;
+        string pending_key;
+
+        cursor.expect('{');
+
+        if (!cursor.consume('}')) {
+            do {
+                string key = cursor.parseString();
+                cursor.expect(':');
+                keys.push_back(key);
+
+                if (key == "instance_uid") {
+                    instance_uid = cursor.parseString();
+                } else if (key == "method") {
+                    method = cursor.parseString();
+                } else if (key == "num_points") {
+                    num_points = int(cursor.parseInteger());
+                    points.reserve(num_points);
+                    pending.reserve(num_points);
+                } else if (key == "num_constraints") {
+                    num_constraints = int(cursor.parseInteger());
+                    additional_constraints.reserve(num_constraints);
+                } else if (key == "points_x" || key == "points_y") {
+                    bool pair_up = !pending_key.empty();
+                    bool x_first = pending_key == "points_x";
+                    size_t i = 0;
+
+                    cursor.expect('[');
+                    if (!cursor.consume(']')) {
+                        do {
+                            K::FT v = cursor.parseCoordinate();
+
+                            if (!pair_up) {
+                                pending.push_back(v);
+                            } else if (i < pending.size()) {
+                                points.emplace_back(x_first ? pending[i] : v, x_first ? v : pending[i]);
+                            }
+                            i++;
+                        } while (cursor.consume(','));
+                        cursor.expect(']');
+                    }
+
+                    if (pair_up) {
+                        if (i != pending.size()) {
+                            cursor.fail("points_x and points_y differ in length");
+                        }
+                        vector<K::FT>().swap(pending);
+                    } else {
+                        pending_key = key;
+                    }
+                } else if (key == "region_boundary") {
+                    cursor.expect('[');
+                    if (!cursor.consume(']')) {
+                        do {
+                            region_boundary.push_back(int(cursor.parseInteger()));
+                        } while (cursor.consume(','));
+                        cursor.expect(']');
+                    }
+                } else if (key == "additional_constraints") {
+                    cursor.expect('[');
+                    if (!cursor.consume(']')) {
+                        do {
+                            cursor.expect('[');
+                            int first = int(cursor.parseInteger());
+                            cursor.expect(',');
+                            int second = int(cursor.parseInteger());
+                            cursor.expect(']');
+                            additional_constraints.emplace_back(first, second);
+                        } while (cursor.consume(','));
+                        cursor.expect(']');
+                    }
+                } else if (key == "parameters" && cursor.peek() == '{') {
+                    cursor.expect('{');
+                    if (!cursor.consume('}')) {
+                        do {
+                            string name = cursor.parseString();
+                            cursor.expect(':');
+                            if (cursor.peek() == '"' || cursor.peek() == '{' || cursor.peek() == '[') {
+                                cursor.skipValue();
+                            } else {
+                                parameters[name] = cursor.parseReal();
+                            }
+                        } while (cursor.consume(','));
+                        cursor.expect('}');
+                    }
+                } else {
+                    cursor.skipValue();
+                }
+            } while (cursor.consume(','));
+
+            cursor.expect('}');
+        }
+
+        if (!cursor.atEnd()) {
+            cursor.fail("trailing data");
+        }
     } catch (const std::exception& e) {
-        std::cerr << "Error reading JSON file: " << e.what() << std::endl;
-        exit(1);
+        throw runtime_error(string("Error reading JSON file: ") + inputfile + ": " + e.what());
     }
 
-    instance_uid = pt.get<std::string>("instance_uid");
-    method = pt.get<std::string>("method");
-    num_points = pt.get<int>("num_points");
-    num_constraints = pt.get<int>("num_constraints");
+    auto require = [&](const char* key) {
+        if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+            throw runtime_error(string("No such node (") + key + ")");
+        }
+    };
 
-    for (auto& point : pt.get_child("points_x")) {
-        points_x.push_back(point.second.get_value<int>());
+    for (const char* key : {"instance_uid", "num_points", "num_constraints", "points_x", "points_y", "region_boundary", "additional_constraints"}) {
+        require(key);
     }
-    for (auto& point : pt.get_child("points_y")) {
-        points_y.push_back(point.second.get_value<int>());
-    }
-    for (auto& boundary : pt.get_child("region_boundary")) {
-        region_boundary.push_back(boundary.second.get_value<int>());
+
+    if (!instance_only) {
+        require("method");
     }
 
-    for (auto& constraint : pt.get_child("additional_constraints")) {
-        int first = constraint.second.front().second.get_value<int>();
-        int second = constraint.second.back().second.get_value<int>();
-        additional_constraints.emplace_back(first, second);
+    setParameters();
+}
+
+void JsonLoader::loadBinary(const char* inputfile) {
+    parameters.clear();
+    points.clear();
+    region_boundary.clear();
+    additional_constraints.clear();
+
+    try {
+        BinaryFile file(inputfile);
+        const BinaryHeader& header = file.header();
+
+        if (header.kind != BinaryFile::INSTANCE) {
+            throw runtime_error("not an instance");
+        }
+
+        instance_uid = file.instanceUid();
+        method = file.label();
+        num_points = int(header.num_points);
+        num_constraints = int(header.num_pairs);
+
+        points.reserve(num_points);
+
+        const int64_t* x = file.integerCoordinates(0);
+        const int64_t* y = file.integerCoordinates(1);
+
+        for (size_t i = 0; i < header.num_points; i++) {
+            if (x != nullptr) {
+                points.emplace_back(K::FT(double(x[i])), K::FT(double(y[i])));
+            } else {
+                points.push_back(file.point(i));
+            }
+        }
+
+        const int32_t* pairs = file.pairs();
+        additional_constraints.reserve(num_constraints);
+
+        for (size_t i = 0; i < header.num_pairs; i++) {
+            additional_constraints.emplace_back(pairs[2 * i], pairs[2 * i + 1]);
+        }
+
+        region_boundary.assign(file.boundary(), file.boundary() + header.num_boundary);
+
+        parameters = file.parameters();
+    } catch (const std::exception& e) {
+        throw runtime_error(string("Error reading binary file: ") + inputfile + ": " + e.what());
     }
 
-    // TODO:
-    // load method, parameters etc.
+    setParameters();
+}
+
+void JsonLoader::setParameters() {
+    auto parameter = [&](const char* name) {
+        auto it = parameters.find(name);
+        if (it == parameters.end()) {
+            throw runtime_error(string("No such node (parameters.") + name + ")");
+        }
+        return it->second;
+    };
 
-    if (method == "legacy") {
-        L = pt.get<int>("parameters.L");
+    if (instance_only) {
+        // The method and its parameters are carried over as they are
+    } else if (method == "legacy") {
+        L = int(parameter("L"));
     } else if (method == "local") {
-        L = pt.get<int>("parameters.L");
+        L = int(parameter("L"));
     } else if (method == "sa") {
-        L = pt.get<int>("parameters.L");
-        alpha = pt.get<float>("parameters.alpha");
-        beta = pt.get<float>("parameters.beta");
+        L = int(parameter("L"));
+        alpha = float(parameter("alpha"));
+        beta = float(parameter("beta"));
     } else if (method == "ant") {
-        L = pt.get<int>("parameters.L");
-        alpha = pt.get<float>("parameters.alpha");
-        beta = pt.get<float>("parameters.beta");
-        xi = pt.get<float>("parameters.xi");
-        psi = pt.get<float>("parameters.psi");
-        lambda = pt.get<float>("parameters.lambda");
-        kappa = pt.get<float>("parameters.kappa");
+        L = int(parameter("L"));
+        alpha = float(parameter("alpha"));
+        beta = float(parameter("beta"));
+        xi = float(parameter("xi"));
+        psi = float(parameter("psi"));
+        lambda = float(parameter("lambda"));
+        kappa = float(parameter("kappa"));
     }
-}
 
-void JsonLoader::print() {
-    std::cout << "Instance UID: " << instance_uid << "\n";
-    std::cout << "Method      : " << method << "\n";
-    std::cout << "Number of Points: " << num_points << "\n";
-    std::cout << "Number of Constraints: " << num_constraints << "\n";
-
-    std::cout << "\nPoints X: ";
-    for (int x : points_x) {
-        std::cout << x << " ";
-    }
+    // Optional: worker threads of the engines that can use them
+    auto t = parameters.find("threads");
+    threads = t == parameters.end() ? 1 : int(t->second);
 
-    std::cout << "\nPoints Y: ";
-    for (int y : points_y) {
-        std::cout << y << " ";
-    }
+    // Optional: seed of the random choices of sa and ant (exact up to 2^53)
+    auto r = parameters.find("seed");
+    seed.reset();
 
-    std::cout << "\nRegion Boundary: ";
-    for (int boundary : region_boundary) {
-        std::cout << boundary << " ";
+    if (r != parameters.end()) {
+        seed = (uint64_t)r->second;
     }
 
-    std::cout << "\nAdditional Constraints:\n";
-    for (const auto& constraint : additional_constraints) {
-        std::cout << "[" << constraint.first << ", " << constraint.second << "]\n";
-    }
+    // Optional: wall-clock budget in seconds
+    auto l = parameters.find("time_limit");
+    time_limit = l == parameters.end() ? 0 : l->second;
 }
 
-vector<Point> JsonLoader::getPoints() {
-    vector<Point> points;
+void JsonLoader::print() {
+    POLYG_LOG(INFO, "Instance UID: " << instance_uid);
+    POLYG_LOG(INFO, "Method      : " << method);
+    POLYG_LOG(INFO, "Threads     : " << threads);
+    POLYG_LOG(INFO, "Number of Points: " << num_points);
+    POLYG_LOG(INFO, "Number of Constraints: " << num_constraints);
+
+    // The whole instance, on large ones only when tracing
+    if (POLYG_LOG_ENABLED(TRACE)) {
+        logging::Line line(logging::TRACE);
+
+        line.stream() << "\nPoints: ";
+        for (const Point& p : points) {
+            line.stream() << "(" << p << ") ";
+        }
 
-    unsigned int N = points_x.size();
+        line.stream() << "\nRegion Boundary: ";
+        for (int boundary : region_boundary) {
+            line.stream() << boundary << " ";
+        }
 
-    for (unsigned int i = 0; i < N; i++) {
-        points.emplace_back(Point(points_x[i], points_y[i]));
+        line.stream() << "\nAdditional Constraints:";
+        for (const auto& constraint : additional_constraints) {
+            line.stream() << "\n[" << constraint.first << ", " << constraint.second << "]";
+        }
     }
+}
 
+const vector<Point>& JsonLoader::getPoints() const {
     return points;
 }
 
-std::vector<std::pair<int, int>> JsonLoader::getConstraints() {
+const std::vector<std::pair<int, int>>& JsonLoader::getConstraints() const {
     return additional_constraints;
 }
 
-std::vector<int> JsonLoader::getRegionBoundaries() {
+const std::vector<int>& JsonLoader::getRegionBoundaries() const {
     return region_boundary;
 }
 
@@ -116,6 +315,22 @@ int JsonLoader::getL() const {
     return L;
 }
 
+int JsonLoader::getThreads() const {
+    return threads < 1 ? 1 : threads;
+}
+
+std::optional<uint64_t> JsonLoader::getSeed() const {
+    return seed;
+}
+
+double JsonLoader::getTimeLimit() const {
+    return time_limit > 0 ? time_limit : 0;
+}
+
+const map<string, double>& JsonLoader::getParameters() const {
+    return parameters;
+}
+
 float JsonLoader::getAlpha() const {
     return alpha;
 }
@@ -139,6 +354,3 @@ float JsonLoader::getLambda() const {
 float JsonLoader::getKappa() const {
     return kappa;
 }
-
-
-
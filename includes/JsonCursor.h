@@ -0,0 +1,346 @@
+#pragma once
+
+// Macros for CGAL
+#include "cgal_definitions.h"
+
+// Standard C++
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Namespaces
+using namespace std;
+
+//
+// Cursor over JSON text (instances, checkpoints): the values are read in
+// place, no tree is built. Syntax errors throw std::runtime_error with the
+// offset.
+//
+class JsonCursor {
+public:
+    JsonCursor(const char* begin, const char* end) : start(begin), p(begin), end(end) {
+    }
+
+    void skipSpaces() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+            p++;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpaces();
+        if (p < end && *p == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            fail(string("expected '") + c + "'");
+        }
+    }
+
+    bool atEnd() {
+        skipSpaces();
+        return p == end;
+    }
+
+    char peek() {
+        skipSpaces();
+        return p < end ? *p : '\0';
+    }
+
+    string parseString() {
+        expect('"');
+
+        string s;
+
+        while (p < end && *p != '"') {
+            if (*p != '\\') {
+                s += *p++;
+                continue;
+            }
+
+            if (++p == end) {
+                break;
+            }
+
+            switch (*p++) {
+            case '"': s += '"'; break;
+            case '\\': s += '\\'; break;
+            case '/': s += '/'; break;
+            case 'b': s += '\b'; break;
+            case 'f': s += '\f'; break;
+            case 'n': s += '\n'; break;
+            case 'r': s += '\r'; break;
+            case 't': s += '\t'; break;
+            case 'u': appendCodePoint(s); break;
+            default: fail("invalid escape sequence");
+            }
+        }
+
+        if (p == end) {
+            fail("unterminated string");
+        }
+        p++;
+
+        return s;
+    }
+
+    // Raw text of a number (or literal) token
+    pair<const char*, const char*> parseToken() {
+        skipSpaces();
+
+        const char* b = p;
+
+        while (p < end && *p != ',' && *p != ']' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+            p++;
+        }
+
+        if (b == p) {
+            fail("expected a value");
+        }
+
+        return {b, p};
+    }
+
+    long long parseInteger() {
+        auto token = parseToken();
+        const char* q = token.first;
+
+        bool negative = *q == '-';
+        if (negative || *q == '+') {
+            q++;
+        }
+
+        if (q == token.second) {
+            fail("expected an integer");
+        }
+
+        long long value = 0;
+        for (; q < token.second; q++) {
+            if (*q < '0' || *q > '9') {
+                fail("expected an integer");
+            }
+            value = value * 10 + (*q - '0');
+        }
+
+        return negative ? -value : value;
+    }
+
+    double parseReal() {
+        auto token = parseToken();
+        char* stop = nullptr;
+
+        // The token is always followed by a delimiter (or the final '\0')
+        double value = strtod(token.first, &stop);
+
+        if (stop != token.second) {
+            fail("expected a number");
+        }
+
+        return value;
+    }
+
+    // A coordinate: integer, decimal or "p/q" string, all read exactly
+    K::FT parseCoordinate() {
+        if (peek() == '"') {
+            const char* b = ++p;
+
+            while (p < end && *p != '"') {
+                p++;
+            }
+
+            if (p == end) {
+                fail("unterminated string");
+            }
+
+            return exactValue(b, p++);
+        }
+
+        auto token = parseToken();
+
+        return exactValue(token.first, token.second);
+    }
+
+    void skipValue() {
+        char c = peek();
+
+        if (c == '"') {
+            parseString();
+        } else if (c == '{') {
+            p++;
+            if (!consume('}')) {
+                do {
+                    parseString();
+                    expect(':');
+                    skipValue();
+                } while (consume(','));
+                expect('}');
+            }
+        } else if (c == '[') {
+            p++;
+            if (!consume(']')) {
+                do {
+                    skipValue();
+                } while (consume(','));
+                expect(']');
+            }
+        } else {
+            parseToken();
+        }
+    }
+
+    [[noreturn]] void fail(const string& what) const {
+        ostringstream message;
+        message << what << " at offset " << (p - start);
+        throw runtime_error(message.str());
+    }
+
+private:
+    const char* start;
+    const char* p;
+    const char* end;
+
+    void appendCodePoint(string& s) {
+        if (end - p < 4) {
+            fail("invalid unicode escape");
+        }
+
+        unsigned int cp = 0;
+        for (int i = 0; i < 4; i++, p++) {
+            char c = *p;
+            cp <<= 4;
+            if (c >= '0' && c <= '9') {
+                cp |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                cp |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                cp |= c - 'A' + 10;
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+
+        if (cp < 0x80) {
+            s += char(cp);
+        } else if (cp < 0x800) {
+            s += char(0xC0 | (cp >> 6));
+            s += char(0x80 | (cp & 0x3F));
+        } else {
+            s += char(0xE0 | (cp >> 12));
+            s += char(0x80 | ((cp >> 6) & 0x3F));
+            s += char(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // Digits of [b, e) as an exact number: up to 15 digits fit a double
+    // exactly, wider ones are accumulated in chunks of 9
+    static K::FT digitsValue(const char* b, const char* e) {
+        if (e - b <= 15) {
+            long long v = 0;
+            for (; b < e; b++) {
+                v = v * 10 + (*b - '0');
+            }
+            return K::FT(double(v));
+        }
+
+        K::FT value(0);
+
+        while (b < e) {
+            const char* chunk_end = b + std::min<long>(9, e - b);
+            long long v = 0, scale = 1;
+            for (; b < chunk_end; b++) {
+                v = v * 10 + (*b - '0');
+                scale *= 10;
+            }
+            value = value * K::FT(double(scale)) + K::FT(double(v));
+        }
+
+        return value;
+    }
+
+    static K::FT powerOfTen(int k) {
+        K::FT r(1);
+
+        for (; k >= 9; k -= 9) {
+            r = r * K::FT(1e9);
+        }
+
+        long long v = 1;
+        while (k-- > 0) {
+            v *= 10;
+        }
+
+        return r * K::FT(double(v));
+    }
+
+    K::FT exactValue(const char* b, const char* e) const {
+        const char* slash = b;
+        while (slash < e && *slash != '/') {
+            slash++;
+        }
+
+        if (slash != e) {
+            return exactValue(b, slash) / exactValue(slash + 1, e);
+        }
+
+        bool negative = b < e && *b == '-';
+        if (negative || (b < e && *b == '+')) {
+            b++;
+        }
+
+        // Mantissa digits without the decimal point, scaled afterwards
+        string digits;
+        int exponent = 0;
+        bool fraction = false;
+
+        for (; b < e && *b != 'e' && *b != 'E'; b++) {
+            if (*b == '.' && !fraction) {
+                fraction = true;
+            } else if (*b >= '0' && *b <= '9') {
+                digits += *b;
+                exponent -= fraction ? 1 : 0;
+            } else {
+                fail("expected a number");
+            }
+        }
+
+        if (digits.empty()) {
+            fail("expected a number");
+        }
+
+        if (b < e) {
+            const char* q = b + 1;
+            bool negative_exponent = q < e && *q == '-';
+            if (negative_exponent || (q < e && *q == '+')) {
+                q++;
+            }
+            if (q == e) {
+                fail("invalid exponent");
+            }
+            int value = 0;
+            for (; q < e; q++) {
+                if (*q < '0' || *q > '9') {
+                    fail("invalid exponent");
+                }
+                value = value * 10 + (*q - '0');
+            }
+            exponent += negative_exponent ? -value : value;
+        }
+
+        K::FT value = digitsValue(digits.data(), digits.data() + digits.size());
+
+        if (exponent > 0) {
+            value = value * powerOfTen(exponent);
+        } else if (exponent < 0) {
+            value = value / powerOfTen(-exponent);
+        }
+
+        return negative ? -value : value;
+    }
+};
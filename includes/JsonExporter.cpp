@@ -1,29 +1,88 @@
-#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
 #include <fstream>
+#include <iostream>
+#include <stdexcept>
 #include <string>
 
+#include "BinaryFormat.h"
 #include "JsonExporter.h"
+#include "ThreadPool.h"
+#include "triangulation_configuration.h"
+#include "utils.hpp"
 
 using namespace std;
 
-JsonExporter::JsonExporter(string instance_uid) {
+namespace {
+
+// Bytes gathered before they are handed to the file
+const size_t FLUSH_SIZE = 1 << 16;
+
+void appendString(string& out, const string& s) {
+    out += '"';
+
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", c);
+                out += code;
+            } else {
+                out += c;
+            }
+        }
+    }
+
+    out += '"';
+}
+
+void appendInt(string& out, int value) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void flush(ofstream& file, string& text, size_t threshold) {
+    if (text.size() >= threshold) {
+        file.write(text.data(), text.size());
+        text.clear();
+    }
+}
+
+} // namespace
+
+JsonExporter::JsonExporter(string instance_uid, int threads) {
     content_type = "CG_SHOP_2025_Solution";
     this->instance_uid = instance_uid;
+    this->threads = threads < 1 ? 1 : threads;
 }
 
 void JsonExporter::print() const {
     std::cout << "Content Type: " << content_type << std::endl;
     std::cout << "Instance UID: " << instance_uid << std::endl;
 
+    string text;
+
     std::cout << "Steiner Points (X): ";
-    for (const auto& x : steiner_points_x) {
-        std::cout << x << " ";
+    for (const Point& p : steiner_points) {
+        text.clear();
+        utils::append_rational(text, p.x());
+        std::cout << text << " ";
     }
     std::cout << std::endl;
 
     std::cout << "Steiner Points (Y): ";
-    for (const auto& y : steiner_points_y) {
-        std::cout << y << " ";
+    for (const Point& p : steiner_points) {
+        text.clear();
+        utils::append_rational(text, p.y());
+        std::cout << text << " ";
     }
     std::cout << std::endl;
 
@@ -35,34 +94,98 @@ void JsonExporter::print() const {
 }
 
 void JsonExporter::save(const char* outputfile) {
-    std::ofstream json_file_out(outputfile);
+    // Binary solution for a *.bin output (see BinaryFormat.h)
+    string name = outputfile;
 
-    for (string temp : steiner_points_x) {
-        pt_steiner_points_x.push_back(boost::property_tree::ptree::value_type("", temp));
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) {
+        BinaryFile::writeSolution(outputfile, instance_uid, content_type, steiner_points, edges);
+        return;
     }
 
-    for (string temp : steiner_points_y) {
-        pt_steiner_points_y.push_back(boost::property_tree::ptree::value_type("", temp));
-    }
+    vector<char> file_buffer(1 << 20);
+    ofstream file;
 
-    for (const auto& edge : edges) {
-        boost::property_tree::ptree edge_node;
+    file.rdbuf()->pubsetbuf(file_buffer.data(), file_buffer.size());
+    file.open(outputfile, ios::binary | ios::trunc);
 
-        std::string x_str = std::to_string(edge.first);
-        std::string y_str = std::to_string(edge.second);
+    if (!file) {
+        throw runtime_error(string("cannot write ") + outputfile);
+    }
 
-        edge_node.push_back(boost::property_tree::ptree::value_type("", x_str));
+    string text;
+
+    text += "{\n    \"content_type\": ";
+    appendString(text, content_type);
+    text += ",\n    \"instance_uid\": ";
+    appendString(text, instance_uid);
+
+    //
+    // Coordinates: formatted a round at a time, one chunk per task, every
+    // buffer reused by the next round
+    //
+    int workers = steiner_points.size() > EXPORT_CHUNK_POINTS ? threads : 1;
+    ThreadPool pool(workers);
+
+    size_t round = (size_t)pool.size() * EXPORT_CHUNK_POINTS;
+    vector<string> chunks(pool.size());
+    vector<K::FT::ET> exact(std::min(round, steiner_points.size()));
+
+    for (int axis = 0; axis < 2; axis++) {
+        text += axis == 0 ? ",\n    \"steiner_points_x\": [" : "],\n    \"steiner_points_y\": [";
+
+        for (size_t first = 0; first < steiner_points.size(); first += round) {
+            size_t n = std::min(round, steiner_points.size() - first);
+
+            // The lazy values are made exact here, on this thread: the tasks
+            // only read plain rationals
+            for (size_t i = 0; i < n; i++) {
+                const Point& p = steiner_points[first + i];
+                exact[i] = CGAL::exact(axis == 0 ? p.x() : p.y());
+            }
+
+            int tasks = (int)((n + EXPORT_CHUNK_POINTS - 1) / EXPORT_CHUNK_POINTS);
+
+            pool.run(tasks, [&](int t) {
+                string& chunk = chunks[t];
+                size_t end = std::min(n, (size_t)(t + 1) * EXPORT_CHUNK_POINTS);
+
+                chunk.clear();
+
+                for (size_t i = (size_t)t * EXPORT_CHUNK_POINTS; i < end; i++) {
+                    if (first + i > 0) {
+                        chunk += ", ";
+                    }
+                    chunk += '"';
+                    utils::append_rational(chunk, exact[i]);
+                    chunk += '"';
+                }
+            });
+
+            for (int t = 0; t < tasks; t++) {
+                text += chunks[t];
+                flush(file, text, FLUSH_SIZE);
+            }
+        }
+    }
 
-        edge_node.push_back(boost::property_tree::ptree::value_type("", y_str));
+    text += "],\n    \"edges\": [";
 
-        pt_edges.push_back(boost::property_tree::ptree::value_type("", edge_node));
+    for (size_t i = 0; i < edges.size(); i++) {
+        text += i > 0 ? ", [" : "[";
+        appendInt(text, edges[i].first);
+        text += ", ";
+        appendInt(text, edges[i].second);
+        text += ']';
+
+        flush(file, text, FLUSH_SIZE);
     }
 
-    pt_root.put("content_type", "CG_SHOP_2025_Solution");
-    pt_root.put("instance_uid", this->instance_uid);
-    pt_root.add_child("steiner_points_x", pt_steiner_points_x);
-    pt_root.add_child("steiner_points_y", pt_steiner_points_y);
-    pt_root.add_child("edges", pt_edges);
-    
-    boost::property_tree::write_json(outputfile, pt_root);
-}
\ No newline at end of file
+    text += "]\n}\n";
+    flush(file, text, 0);
+
+    file.close();
+
+    if (!file) {
+        throw runtime_error(string("cannot write ") + outputfile);
+    }
+}
@@ -1,8 +1,5 @@
 #pragma once
 
-// boost
-#include "boost_definitions.h"
-
 // Macros for CGAL
 #include "cgal_definitions.h"
 
@@ -15,23 +12,25 @@
 using namespace std;
 
 
-
+//
+// Solution writer: the Steiner points and the edges are streamed to a
+// buffered file, the exact coordinates formatted as "p/q" in reused buffers
+// (by chunks on several threads for large solutions). An output named
+// *.bin gets the binary format instead (see BinaryFormat.h).
+//
 class JsonExporter {
 private:
-    boost::property_tree::ptree pt_root;
-    boost::property_tree::ptree pt_steiner_points_x;
-    boost::property_tree::ptree pt_steiner_points_y;
-    boost::property_tree::ptree pt_edges;
+    int threads;
+
 public:
 
     string content_type;
     string instance_uid;
-    vector<string> steiner_points_x;
-    vector<string> steiner_points_y;
+    vector<Point> steiner_points;
     vector<std::pair<int, int>> edges;
 
-    JsonExporter(string instance_uid);
+    JsonExporter(string instance_uid, int threads = 1);
 
-    void save(const char* inputfile);
+    void save(const char* outputfile);
     void print() const;
-};
\ No newline at end of file
+};
@@ -1,41 +1,59 @@
 #pragma once
 
-// boost
-#include "boost_definitions.h"
-
 // Macros for CGAL
 #include "cgal_definitions.h"
 
 // Standard C++
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <optional>
+#include <string>
 #include <vector>
 
 // Namespaces
 using namespace std;
 
+//
+// Instance loader: one pass over the file, the coordinates are parsed
+// straight into the points (integers of any width, decimals and "p/q"
+// rationals, all exact) and exposed by reference. Binary instances (see
+// BinaryFormat.h) are recognized by their magic and copied from the mapping.
+//
 class JsonLoader {
 private:
-    boost::property_tree::ptree pt;
-
     string instance_uid;
     string method;
     int num_points;
     int num_constraints;
-    vector<int> points_x, points_y, region_boundary;
+    vector<Point> points;
+    vector<int> region_boundary;
     vector<std::pair<int, int>> additional_constraints;
-    int L;    
+    int L;
+    int threads;
+    std::optional<uint64_t> seed;
+    double time_limit;
+    map<string, double> parameters;
+    bool instance_only = false;
+
+    void loadBinary(const char* inputfile);
+
+    // The parameters of the method, the optional ones
+    void setParameters();
 
-    
 public:
-    void load(const char* inputfile);
+    // Throws std::runtime_error if the file is unreadable, malformed or
+    // incomplete. instance_only: a plain CG:SHOP instance will do, the method
+    // and its parameters are optional (converter)
+    void load(const char* inputfile, bool instance_only = false);
 
     void print();
 
-    vector<Point> getPoints();
+    const vector<Point>& getPoints() const;
 
-    std::vector<std::pair<int, int>> getConstraints() ;
+    const std::vector<std::pair<int, int>>& getConstraints() const;
 
-    std::vector<int> getRegionBoundaries();    
+    const std::vector<int>& getRegionBoundaries() const;
 
     string getInstance() const;
 
@@ -43,6 +61,17 @@ public:
 
     int getL() const;
 
+    int getThreads() const;
+
+    // parameters.seed, when the instance fixes its random choices
+    std::optional<uint64_t> getSeed() const;
+
+    // parameters.time_limit: seconds for the run (anytime mode), 0 for none
+    double getTimeLimit() const;
+
+    // Every numeric entry of parameters (for the converter)
+    const map<string, double>& getParameters() const;
+
     float alpha, beta, xi, psi, lambda, kappa;
 
     float getAlpha() const;
@@ -54,6 +83,6 @@ public:
     float getPsi() const;
 
     float getLambda() const;
-    
+
     float getKappa() const;
-};
\ No newline at end of file
+};
@@ -1,7 +1,10 @@
 // Standard C++
+#include <array>
 #include <gmp.h>
 #include <iostream>
 #include <map>
+#include <type_traits>
+#include <unordered_set>
 #include <vector>
 
 // Macros and headers for CGAL
@@ -18,7 +21,13 @@
 
 // Support classes
 #include "JsonExporter.h"
+#include "Deadline.h"
 #include "JsonLoader.h"
+#include "ObtuseFaceWorklist.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "SteinerCandidateCache.h"
+#include "ThreadPool.h"
 #include "graph_definitions.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
@@ -26,10 +35,246 @@
 // Namespaces
 using namespace std;
 
-template <typename T>
+template <class Traits>
 class LocalSearch {
+    // utils, steiner_strategies and the loader are built for the kernel of cgal_definitions.h
+    static_assert(std::is_same<typename Traits::CDT, CDT>::value, "Traits must match the kernel of this build (POLYG_EXACT_NT)");
+
+private:
+    // Trial insertion evaluated by the thread pool on a local patch
+    struct Trial {
+        int face; // index in the batch
+        steiner_stategies::Strategy strategy;
+        SteinerCandidateCache::Candidate* candidate;
+        CDT::Locate_type lt;
+        CDT::Face_handle loc;
+        int li;
+        bool evaluated;
+        int delta;
+    };
+
+    //
+    // One sweep with the trials evaluated by the threads of the pool. Obtuse
+    // faces are taken in batches whose neighborhoods do not overlap; all the
+    // trials of a batch run in parallel on local patches of the unchanged
+    // triangulation, then the winners are inserted in face order. The batches
+    // do not depend on the pool, so every pool of two threads or more gives
+    // the same result; it differs from the one of the sequential sweep that
+    // a single thread runs.
+    //
+    void parallelSweep(vector<steiner_stategies::Strategy>& strategies, Graph& graph, Polygon& boundaryPolygon, ThreadPool& pool, SteinerCandidateCache& cache,
+                       std::vector<std::array<CDT::Vertex_handle, 3>>& finite_faces, vector<Point>& steinerPoints, int iteration, Deadline& deadline) {
+        CDT& cdt = *(graph.cdt);
+        size_t next = 0;
+
+        while (next < finite_faces.size() && !deadline.expired()) {
+            //
+            // Batch
+            //
+            vector<std::array<Point, 3>> batch;
+            vector<std::array<CDT::Vertex_handle, 3>> batch_faces; // also the start of the point location
+            std::unordered_set<const Face*> claimed;
+
+            for (; next < finite_faces.size() && (int)batch.size() < PARALLEL_BATCH_FACES; next++) {
+                std::array<CDT::Vertex_handle, 3>& face_vertices = finite_faces[next];
+                CDT::Face_handle fit;
+
+                if (!cdt.is_face(face_vertices[0], face_vertices[1], face_vertices[2], fit)) {
+                    continue; // split by an earlier insertion
+                }
+
+                Point a = fit->vertex(0)->point();
+                Point b = fit->vertex(1)->point();
+                Point c = fit->vertex(2)->point();
+
+                if (!utils::is_obtuse(a, b, c)) {
+                    continue;
+                }
+
+                std::vector<CDT::Face_handle> neighborhood;
+                std::unordered_set<const Face*> in_neighborhood;
+
+                cdt.k_ring(fit, LOCAL_PATCH_RINGS + 1, neighborhood, in_neighborhood);
+
+                bool overlaps = false;
+
+                for (CDT::Face_handle f : neighborhood) {
+                    if (claimed.count(&*f) != 0) {
+                        overlaps = true;
+                        break;
+                    }
+                }
+
+                if (overlaps) {
+                    break; // first face of the next batch
+                }
+
+                claimed.insert(in_neighborhood.begin(), in_neighborhood.end());
+
+                batch.push_back({a, b, c});
+                batch_faces.push_back(face_vertices);
+            }
+
+            int obtuse_triangles_now = utils::countObtuseTriangles(cdt);
+            vector<map<steiner_stategies::Strategy, int>> options(batch.size());
+            vector<Trial> trials;
+
+            //
+            // POLYGON adds constraints while generating its point: tried in place, one face at a time
+            //
+            for (size_t k = 0; k < batch.size(); k++) {
+                for (steiner_stategies::Strategy& strategy : strategies) {
+                    if (strategy != steiner_stategies::Strategy::POLYGON) {
+                        continue;
+                    }
+
+                    cdt.begin_transaction();
+
+                    steiner_stategies::SteinerPoint s = steiner_stategies::generateSteinerPoint(graph, batch[k][0], batch[k][1], batch[k][2], strategy);
+
+                    if (s) {
+                        int copy_obtuse_triangles_after = obtuse_triangles_now;
+
+                        if (boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
+                            cdt.insert(*s);
+                            copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+                        }
+
+                        options[k][strategy] = copy_obtuse_triangles_after;
+                    }
+
+                    cdt.rollback();
+                }
+            }
+
+            //
+            // The other points: taken from the cache and located here (locate() is not thread
+            // safe); the pool evaluates the ones whose patch changed since their last evaluation
+            //
+            for (size_t k = 0; k < batch.size(); k++) {
+                Point& a = batch[k][0];
+                Point& b = batch[k][1];
+                Point& c = batch[k][2];
+
+                cache.prepare(batch_faces[k], strategies);
+
+                for (steiner_stategies::Strategy& strategy : strategies) {
+                    if (strategy == steiner_stategies::Strategy::POLYGON) {
+                        continue;
+                    }
+
+                    if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
+                        int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
+                        if (i == -1) {
+                            POLYG_LOG(ERROR, "CRITICAL ERROR: find_obtuse_angle failed ");
+                            exit(1);
+                        }
+
+                        std::tuple<int, int> edge_indices = utils::findOppositeEdge(i); // a:1,2 b:0,2 c:0,1
+
+                        if (utils::checkConstraints(cdt, batch[k][std::get<0>(edge_indices)], batch[k][std::get<1>(edge_indices)])) {
+                            continue;
+                        }
+                    }
+
+                    SteinerCandidateCache::Candidate& candidate = cache.candidate(batch_faces[k], strategy);
+
+                    if (!candidate.generated) {
+                        continue;
+                    }
+
+                    if (!candidate.inside) {
+                        options[k][strategy] = obtuse_triangles_now;
+                        continue;
+                    }
+
+                    Trial trial;
+                    trial.face = (int)k;
+                    trial.strategy = strategy;
+                    trial.candidate = &candidate;
+                    trial.evaluated = false;
+                    trial.delta = 0;
+
+                    if (cache.is_current(candidate, batch_faces[k][0]->face(), trial.lt, trial.loc, trial.li)) {
+                        options[k][strategy] = obtuse_triangles_now + candidate.delta;
+                    } else {
+                        trials.push_back(trial);
+                    }
+                }
+            }
+
+            // The lazy values the threads share are computed here, serially
+            for (const Trial& trial : trials) {
+                cdt.make_patch_exact(trial.candidate->point, trial.loc, LOCAL_PATCH_RINGS);
+            }
+
+            pool.run((int)trials.size(), [&](int j) {
+                Trial& trial = trials[j];
+
+                trial.evaluated = cdt.patch_obtuse_delta(trial.candidate->point, false, trial.lt, trial.loc, trial.li, LOCAL_PATCH_RINGS, trial.delta);
+            });
+
+            for (Trial& trial : trials) {
+                if (!trial.evaluated) { // point on the border of its patch
+                    trial.delta = cdt.obtuse_delta_of_insertion(trial.candidate->point, false, batch_faces[trial.face][0]->face(), LOCAL_PATCH_RINGS);
+                }
+
+                cache.set_delta(*trial.candidate, trial.delta);
+
+                options[trial.face][trial.strategy] = obtuse_triangles_now + trial.delta;
+            }
+
+            //
+            // Winners, in face order
+            //
+            for (size_t k = 0; k < batch.size(); k++) {
+                Point& a = batch[k][0];
+                Point& b = batch[k][1];
+                Point& c = batch[k][2];
+
+                POLYG_LOG(DEBUG, " - Iteration: " << iteration << " Checking triangle: " << a << "," << b << "," << c << ", obtuse:1, obtuse triangles: " << obtuse_triangles_now);
+
+                int min_value = std::numeric_limits<int>::max();
+                steiner_stategies::Strategy strategy = steiner_stategies::Strategy::NONE;
+
+                for (const auto& [key, value] : options[k]) {
+                    POLYG_LOG(TRACE, "\t" << steiner_stategies::strategyLabel(key) << " - Method succeeded " << value);
+
+                    if (value < min_value) {
+                        min_value = value;
+                        strategy = key;
+                    }
+                }
+
+                if (strategy == steiner_stategies::Strategy::NONE) {
+                    continue;
+                }
+
+                POLYG_LOG(DEBUG, "*Strategy selected: " << steiner_stategies::strategyLabel(strategy));
+
+                if (strategy == steiner_stategies::Strategy::POLYGON) {
+                    steiner_stategies::SteinerPoint s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
+
+                    if (s && boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
+                        cdt.insert(*s);
+                        steinerPoints.emplace_back(*s);
+                        POLYG_COUNT_INSERTION(strategy);
+                    }
+                } else {
+                    SteinerCandidateCache::Candidate& candidate = cache.candidate(batch_faces[k], strategy);
+
+                    if (candidate.inside) {
+                        cdt.insert_no_flip(candidate.point, batch_faces[k][0]->face());
+                        steinerPoints.emplace_back(candidate.point);
+                        POLYG_COUNT_INSERTION(strategy);
+                    }
+                }
+            }
+        }
+    }
+
 public:
-    vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon) {
+    vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon, Deadline& deadline) {
         vector<Point> steinerPoints;
         CDT& cdt = *(graph.cdt);
 
@@ -38,132 +283,185 @@ public:
         int obtuse_triangles_before = 0;
         int obtuse_triangles_after = 0;
 
-        cout << "# Max iterations: " << MAX_ITERATIONS << endl;
+        ThreadPool pool(loader.getThreads());
+        ObtuseFaceWorklist worklist(cdt);
+        SteinerCandidateCache cache(graph, boundaryPolygon);
+
+        POLYG_LOG(INFO, "# Max iterations: " << MAX_ITERATIONS);
+        POLYG_LOG(INFO, "# Threads: " << pool.size());
 
-        for (int i = 1; i <= MAX_ITERATIONS; i++) {
+        // Under a budget: the fewest obtuse triangles seen, in case the search is stopped
+        BestSolution<CDT, Point> best(deadline.budgeted());
+        best.offer(obtuse_triangles_initial, cdt, steinerPoints);
+
+        for (int i = 1; i <= MAX_ITERATIONS && !deadline.expired(); i++) {
             int conflicts = 0;
 
             obtuse_triangles_before = utils::countObtuseTriangles(cdt);
             obtuse_triangles_after = 0;
 
-            std::vector<CDT::Face_handle> finite_faces;
-
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
+            // The obtuse faces, most severe first. Faces are kept by their
+            // vertices: an insertion (or a rolled back trial that crossed a
+            // constraint) may destroy the face handles
+            std::vector<std::array<CDT::Vertex_handle, 3>> finite_faces = worklist.take_round();
 
             //
             // Optimization algorithm
             //
 
-            for (auto fit : finite_faces) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
+            if (pool.size() > 1) {
+                parallelSweep(strategies, graph, boundaryPolygon, pool, cache, finite_faces, steinerPoints, i, deadline);
+            } else {
+                for (auto& face_vertices : finite_faces) {
+                    CDT::Face_handle fit;
+
+                    if (deadline.expired()) {
+                        break;
+                    }
+
+                    if (!cdt.is_face(face_vertices[0], face_vertices[1], face_vertices[2], fit)) {
+                        continue; // split by an earlier insertion
+                    }
+
+                    Point a = fit->vertex(0)->point();
+                    Point b = fit->vertex(1)->point();
+                    Point c = fit->vertex(2)->point();
+
+                    bool result = utils::is_obtuse(a, b, c);
+
+                    POLYG_LOG(DEBUG, " - Iteration: " << i << " Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << ", obtuse triangles: " << obtuse_triangles_before);
+
+                    conflicts++;
+
+                    if (result) {                    
+                        // ---------------------------------------------------------
+                        map<steiner_stategies::Strategy, int> options;
 
-                bool result = utils::is_obtuse(a, b, c);
+                        Point vertices[3] = {a, b, c};
 
-                cout << " - Iteration: " << i << " Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << ", obtuse triangles: " << obtuse_triangles_before << endl;
+                        // Every point of the face from a single pass over its geometry
+                        cache.prepare(face_vertices, strategies);
 
-                conflicts++;
+                        for (steiner_stategies::Strategy& strategy : strategies) {
+                            if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
+                                int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
+                                if (i == -1) {
+                                    POLYG_LOG(ERROR, "CRITICAL ERROR: find_obtuse_angle failed ");
+                                    exit(1);
+                                }
+
+                                std::tuple<int, int> edge_indices = utils::findOppositeEdge(i); // a:1,2 b:0,2 c:0,1
 
-                if (result) {                    
-                    // ---------------------------------------------------------
-                    map<steiner_stategies::Strategy, int> options;
+                                Point& p1 = vertices[std::get<0>(edge_indices)];
+                                Point& p2 = vertices[std::get<1>(edge_indices)];
 
-                    for (steiner_stategies::Strategy& strategy : strategies) {
-                        CDT cdt_copy = cdt;
-                        Graph graph_copy;
-                        graph_copy.cdt = &cdt_copy;
+                                bool is_constraint = utils::checkConstraints(cdt, p1, p2);
 
-                        if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
-                            int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
-                            if (i == -1) {
-                                cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
-                                exit(1);
+                                if (is_constraint) {
+                                    continue;
+                                }
                             }
 
-                            std::tuple<int, int> edge_indices = utils::findOppositeEdge(i); // a:1,2 b:0,2 c:0,1
+                            if (strategy != steiner_stategies::Strategy::POLYGON) {
+                                // Tried on a local patch around the face; point and delta are
+                                // reused from earlier sweeps while the patch is unchanged
+                                SteinerCandidateCache::Candidate& candidate = cache.candidate(face_vertices, strategy);
 
-                            Point& p1 = fit->vertex(std::get<0>(edge_indices))->point();
-                            Point& p2 = fit->vertex(std::get<1>(edge_indices))->point();
+                                if (candidate.generated) {
+                                    int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt);
 
-                            bool is_constraint = utils::checkConstraints(cdt, p1, p2);
+                                    if (candidate.inside) {
+                                        copy_obtuse_triangles_after += cache.delta(candidate, face_vertices[0]->face());
+                                    }
+
+                                    options[strategy] = copy_obtuse_triangles_after;
+
+                                    POLYG_LOG(TRACE, "\t" << steiner_stategies::strategyLabel(strategy) << " - Method succeeded " << copy_obtuse_triangles_after);
+                                } else {
+                                    POLYG_LOG(TRACE, "\t" << steiner_stategies::strategyLabel(strategy) << " - Method failed    ");
+                                }
 
-                            if (is_constraint) {
                                 continue;
                             }
-                        }
 
-                        Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, strategy);
+                            // POLYGON adds constraints while generating its point, so its trial runs
+                            // in place and is undone by the rollback (which may recreate fit)
+                            cdt.begin_transaction();
+
+                            steiner_stategies::SteinerPoint s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
 
-                        if (s != nullptr) {
-                            if (boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
-                                // cout << "Inserting ... " << s << endl;
-                                if (strategy == steiner_stategies::Strategy::POLYGON) {
-                                    cdt_copy.insert(*s);
+                            if (s) {
+                                int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+
+                                if (boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
+                                    // cout << "Inserting ... " << s << endl;
+                                    cdt.insert(*s);
+                                    copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt);
                                 } else {
-                                    cdt_copy.insert_no_flip(*s);
+                                    // cout << "Steiner point ignored  - outside the boundaries " << endl;
                                 }
-                            } else {
-                                // cout << "Steiner point ignored  - outside the boundaries " << endl;
-                            }
 
-                            delete s;
+                                cdt.rollback();
 
-                            int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy) ;
+                                options[strategy] = copy_obtuse_triangles_after;
 
-                            options[strategy] = copy_obtuse_triangles_after;
+                                POLYG_LOG(TRACE, "\t" << steiner_stategies::strategyLabel(strategy) << " - Method succeeded " << copy_obtuse_triangles_after);
+                            } else {
+                                cdt.rollback();
 
-                            cout << "\t";
-                            steiner_stategies::printStrategy(strategy);
-                            cout << " - Method succeeded " << copy_obtuse_triangles_after << endl;
-                        } else {
-                            cout << "\t";
-                            steiner_stategies::printStrategy(strategy);
-                            cout << " - Method failed    " << endl;
-                        }
+                                POLYG_LOG(TRACE, "\t" << steiner_stategies::strategyLabel(strategy) << " - Method failed    ");
+                            }
 
-                    }
-                    // ---------------------------------------------------------
-                    int min_value = std::numeric_limits<int>::max();
-                    steiner_stategies::Strategy strategy = steiner_stategies::Strategy::NONE;
-
-                    for (const auto& [key, value] : options) {
-                        if (value < min_value) {
-                            min_value = value;
-                            strategy = key;
                         }
-                    }
+                        // ---------------------------------------------------------
+                        int min_value = std::numeric_limits<int>::max();
+                        steiner_stategies::Strategy strategy = steiner_stategies::Strategy::NONE;
+
+                        for (const auto& [key, value] : options) {
+                            if (value < min_value) {
+                                min_value = value;
+                                strategy = key;
+                            }
+                        }
 
-                    if (strategy != steiner_stategies::Strategy::NONE) {                        
-                        Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
+                        if (strategy == steiner_stategies::Strategy::POLYGON) {
+                            steiner_stategies::SteinerPoint s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
 
-                        cout << "*Strategy selected: " ;
+                            POLYG_LOG(DEBUG, "*Strategy selected: " << steiner_stategies::strategyLabel(strategy));
 
-                        steiner_stategies::printStrategy(strategy);
+                            if (s && boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
+                                cdt.insert(*s);
+                                steinerPoints.emplace_back(*s);
+                                POLYG_COUNT_INSERTION(strategy);
+                            } else {
+                                // cout << "Steiner point ignored  - outside the boundaries " << endl;
+                            }
+                        } else if (strategy != steiner_stategies::Strategy::NONE) {
+                            SteinerCandidateCache::Candidate& candidate = cache.candidate(face_vertices, strategy);
 
-                        cout << endl;
+                            POLYG_LOG(DEBUG, "*Strategy selected: " << steiner_stategies::strategyLabel(strategy));
 
-                        if (boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
-                            if (strategy == steiner_stategies::Strategy::POLYGON) {
-                                cdt.insert(*s);
+                            if (candidate.inside) {
+                                cdt.insert_no_flip(candidate.point, face_vertices[0]->face());
+                                steinerPoints.emplace_back(candidate.point);
+                                POLYG_COUNT_INSERTION(strategy);
                             } else {
-                                cdt.insert_no_flip(*s);
+                                // cout << "Steiner point ignored  - outside the boundaries " << endl;
                             }
-                            steinerPoints.emplace_back(*s);
-                        } else {
-                            // cout << "Steiner point ignored  - outside the boundaries " << endl;
                         }
-
-                        delete s;
                     }
                 }
             }
 
+            // Faces the sweep did not fix stay for the next one
+            worklist.requeue(finite_faces);
+            cache.prune();
+
             obtuse_triangles_after = utils::countObtuseTriangles(cdt);
 
-            cout << " ### Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before << endl;
+            best.offer(obtuse_triangles_after, cdt, steinerPoints);
+
+            POLYG_LOG(INFO, " ### Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before);
             // if (obtuse_triangles_after >= obtuse_triangles_before || conflicts == 0 || obtuse_triangles_after == 0) {
             //     break;
             // }
@@ -173,11 +471,21 @@ public:
             }
         }
 
-        cout << "***********************************************************************" << endl;
-        cout << " - Initial obtuse triangles  : " << obtuse_triangles_initial << endl;
-        cout << " - Total obtuse triangles    : " << obtuse_triangles_after << endl;
-        cout << " - Total steiner points      : " << steinerPoints.size() << endl;
-        cout << "***********************************************************************" << endl;
+        if (deadline.expired()) {
+            POLYG_LOG(INFO, "# Search stopped: time budget or cancellation");
+        }
+
+        obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+
+        if (best.restore(obtuse_triangles_after, cdt, steinerPoints)) {
+            obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+        }
+
+        POLYG_LOG(INFO, "***********************************************************************");
+        POLYG_LOG(INFO, " - Initial obtuse triangles  : " << obtuse_triangles_initial);
+        POLYG_LOG(INFO, " - Total obtuse triangles    : " << obtuse_triangles_after);
+        POLYG_LOG(INFO, " - Total steiner points      : " << steinerPoints.size());
+        POLYG_LOG(INFO, "***********************************************************************");
 
         return steinerPoints;
     }
@@ -0,0 +1,163 @@
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Log.h"
+
+using namespace std;
+
+namespace {
+
+logging::Level initialLevel() {
+    logging::Level level = logging::INFO;
+    const char* name = getenv("POLYG_LOG");
+
+    if (name != nullptr && !logging::parseLevel(name, level)) {
+        fprintf(stderr, "Unknown POLYG_LOG level %s, using info\n", name);
+    }
+
+    return level;
+}
+
+//
+// Writer thread of the queued lines, started by the first one. The lines
+// are taken in batches and printed with one write each, so the searching
+// threads only pay for building the line and a short lock.
+//
+class Sink {
+public:
+    ~Sink() {
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            stopping = true;
+        }
+
+        queued.notify_one();
+
+        if (writer.joinable()) {
+            writer.join();
+        }
+    }
+
+    void push(string&& line) {
+        {
+            lock_guard<mutex> lock(queue_mutex);
+
+            if (!writer.joinable()) {
+                writer = thread(&Sink::run, this);
+            }
+
+            pending.push_back(std::move(line));
+            pushed++;
+        }
+
+        queued.notify_one();
+    }
+
+    void flush() {
+        unique_lock<mutex> lock(queue_mutex);
+        uint64_t target = pushed;
+
+        printed_cv.wait(lock, [&] { return printed >= target; });
+    }
+
+private:
+    void run() {
+        vector<string> batch;
+        string text;
+
+        unique_lock<mutex> lock(queue_mutex);
+
+        while (true) {
+            queued.wait(lock, [&] { return stopping || !pending.empty(); });
+
+            if (pending.empty()) {
+                break; // stopping, nothing left
+            }
+
+            batch.swap(pending);
+            lock.unlock();
+
+            text.clear();
+
+            for (const string& line : batch) {
+                text += line;
+            }
+
+            fwrite(text.data(), 1, text.size(), stdout);
+            fflush(stdout);
+
+            lock.lock();
+            printed += batch.size();
+            batch.clear();
+            printed_cv.notify_all();
+        }
+    }
+
+    mutex queue_mutex;
+    condition_variable queued;
+    condition_variable printed_cv;
+    vector<string> pending;
+    uint64_t pushed = 0;
+    uint64_t printed = 0;
+    bool stopping = false;
+    thread writer;
+};
+
+Sink& sink() {
+    static Sink instance;
+    return instance;
+}
+
+} // namespace
+
+std::atomic<int> logging::runtime_level(initialLevel());
+
+void logging::setLevel(Level level) {
+    runtime_level.store((int)level, memory_order_relaxed);
+}
+
+logging::Level logging::level() {
+    return (Level)runtime_level.load(memory_order_relaxed);
+}
+
+bool logging::parseLevel(const std::string& name, Level& level) {
+    for (int l = ERROR; l <= TRACE; l++) {
+        if (name == levelName((Level)l)) {
+            level = (Level)l;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* logging::levelName(Level level) {
+    switch (level) {
+    case ERROR: return "error";
+    case WARN: return "warn";
+    case INFO: return "info";
+    case DEBUG: return "debug";
+    case TRACE: return "trace";
+    default: return "unknown";
+    }
+}
+
+void logging::write(Level level, std::string&& line) {
+    if (level <= WARN) {
+        sink().flush();
+        fputs(line.c_str(), stderr);
+        return;
+    }
+
+    sink().push(std::move(line));
+}
+
+void logging::flush() {
+    sink().flush();
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+//
+// Leveled logging: ERROR, WARN, INFO, DEBUG, TRACE.
+//  - POLYG_LOG_LEVEL (CMake) is the most detailed level compiled in: the
+//    statements above it are discarded by the compiler, their arguments are
+//    never evaluated,
+//  - the runtime level (POLYG_LOG environment variable, or setLevel) filters
+//    the ones compiled in with a single load,
+//  - the lines of the enabled levels are queued to a writer thread, which
+//    prints them to stdout in batches; ERROR and WARN go to stderr at once,
+//    after the lines already queued.
+//
+// POLYG_LOG(DEBUG, "Checking triangle: " << a << "," << b << "," << c);
+//
+namespace logging {
+
+enum Level {
+    ERROR,
+    WARN,
+    INFO,
+    DEBUG,
+    TRACE,
+};
+
+extern std::atomic<int> runtime_level;
+
+inline bool enabled(Level level) {
+    return (int)level <= runtime_level.load(std::memory_order_relaxed);
+}
+
+void setLevel(Level level);
+
+Level level();
+
+// error, warn, info, debug or trace; false for anything else
+bool parseLevel(const std::string& name, Level& level);
+
+const char* levelName(Level level);
+
+// Queues (or, for ERROR and WARN, prints) one line
+void write(Level level, std::string&& line);
+
+// Waits until every queued line is printed
+void flush();
+
+// One line: built in place, written when it goes out of scope
+class Line {
+public:
+    explicit Line(Level level) : level(level) {}
+
+    ~Line() {
+        buffer << '\n';
+        write(level, buffer.str());
+    }
+
+    std::ostream& stream() {
+        return buffer;
+    }
+
+    Line(const Line&) = delete;
+    Line& operator=(const Line&) = delete;
+
+private:
+    Level level;
+    std::ostringstream buffer;
+};
+
+} // namespace logging
+
+// Most detailed level compiled in, from -DPOLYG_LOG_LEVEL_<LEVEL>
+#if defined(POLYG_LOG_LEVEL_ERROR)
+#define POLYG_LOG_LEVEL logging::ERROR
+#elif defined(POLYG_LOG_LEVEL_WARN)
+#define POLYG_LOG_LEVEL logging::WARN
+#elif defined(POLYG_LOG_LEVEL_INFO)
+#define POLYG_LOG_LEVEL logging::INFO
+#elif defined(POLYG_LOG_LEVEL_TRACE)
+#define POLYG_LOG_LEVEL logging::TRACE
+#else
+#define POLYG_LOG_LEVEL logging::DEBUG
+#endif
+
+// For lines built over several statements: if (POLYG_LOG_ENABLED(TRACE)) { logging::Line line(logging::TRACE); ... }
+#define POLYG_LOG_ENABLED(level) (logging::level <= POLYG_LOG_LEVEL && logging::enabled(logging::level))
+
+#define POLYG_LOG(level, message)                                            \
+    do {                                                                     \
+        if constexpr (logging::level <= POLYG_LOG_LEVEL) {                   \
+            if (logging::enabled(logging::level)) {                          \
+                logging::Line polyg_log_line(logging::level);                \
+                polyg_log_line.stream() << message;                          \
+            }                                                                \
+        }                                                                    \
+    } while (0)
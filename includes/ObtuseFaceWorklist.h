@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+#include "cgal_definitions.h"
+#include "utils.hpp"
+
+//
+// Obtuse faces of a triangulation, most severe (largest radius to height
+// ratio) first. The triangulation reports the faces each operation creates
+// or modifies, so only those are examined again; entries of faces that have
+// disappeared since are dropped when they come out of the queue. Faces are
+// kept by their vertices, which outlive the face handles.
+//
+class ObtuseFaceWorklist {
+public:
+    typedef std::array<CDT::Vertex_handle, 3> Face_vertices;
+
+    ObtuseFaceWorklist(CDT& cdt) : cdt(cdt) {
+        for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
+            push(fit);
+        }
+
+        cdt.set_face_observer([this](CDT::Face_handle f) { push(f); });
+    }
+
+    ~ObtuseFaceWorklist() {
+        cdt.set_face_observer(nullptr);
+    }
+
+    ObtuseFaceWorklist(const ObtuseFaceWorklist&) = delete;
+    ObtuseFaceWorklist& operator=(const ObtuseFaceWorklist&) = delete;
+
+    // Queue f if it is obtuse (and not queued yet)
+    void push(CDT::Face_handle f) {
+        if (cdt.is_infinite(f) || !cdt.is_obtuse_face(f)) {
+            return;
+        }
+
+        Face_vertices v = {f->vertex(0), f->vertex(1), f->vertex(2)};
+
+        if (!queued.insert(key(v)).second) {
+            return;
+        }
+
+        heap.push({utils::radius_to_height_ratio(v[0]->point(), v[1]->point(), v[2]->point()), v});
+    }
+
+    // Most severe obtuse face, false once there is none
+    bool pop(CDT::Face_handle& f) {
+        while (!heap.empty()) {
+            Entry e = heap.top();
+            heap.pop();
+            queued.erase(key(e.vertices));
+
+            if (cdt.is_face(e.vertices[0], e.vertices[1], e.vertices[2], f) && cdt.is_obtuse_face(f)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Every obtuse face queued now, most severe first; the queue is left empty
+    std::vector<Face_vertices> take_round() {
+        std::vector<Face_vertices> faces;
+        CDT::Face_handle f;
+
+        faces.reserve(heap.size());
+
+        while (pop(f)) {
+            faces.push_back({f->vertex(0), f->vertex(1), f->vertex(2)});
+        }
+
+        return faces;
+    }
+
+    // Queue again the faces of a round that still exist (and are obtuse)
+    void requeue(const std::vector<Face_vertices>& faces) {
+        CDT::Face_handle f;
+
+        for (const Face_vertices& v : faces) {
+            if (cdt.is_face(v[0], v[1], v[2], f)) {
+                push(f);
+            }
+        }
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    // Entries queued, including the ones that may have gone stale
+    std::size_t size() const {
+        return heap.size();
+    }
+
+private:
+    struct Entry {
+        float severity;
+        Face_vertices vertices;
+
+        bool operator<(const Entry& other) const {
+            return severity < other.severity;
+        }
+    };
+
+    typedef std::array<const void*, 3> Key;
+
+    struct Key_hash {
+        std::size_t operator()(const Key& k) const {
+            std::hash<const void*> h;
+            return (h(k[0]) * 31 + h(k[1])) * 31 + h(k[2]);
+        }
+    };
+
+    // The vertices of a face in a fixed order, whatever its rotation
+    static Key key(const Face_vertices& v) {
+        Key k = {&*v[0], &*v[1], &*v[2]};
+        std::sort(k.begin(), k.end());
+        return k;
+    }
+
+    CDT& cdt;
+    std::priority_queue<Entry> heap;
+    std::unordered_set<Key, Key_hash> queued;
+};
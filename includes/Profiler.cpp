@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "Profiler.h"
+
+using namespace std;
+
+bool profiler::enabled = false;
+profiler::PrimitiveTimes profiler::primitives[PRIMITIVES];
+
+namespace {
+
+// Blocks of the running threads, and the totals of the threads that ended
+std::mutex blocks_mutex;
+std::vector<profiler::CounterBlock*> blocks;
+profiler::Counters retired = {};
+
+thread_local profiler::Context* current_context = nullptr;
+
+profiler::Counters threadCounters() {
+    profiler::Counters values;
+    profiler::CounterBlock& block = profiler::localCounters();
+
+    for (int i = 0; i < profiler::COUNTERS; i++) {
+        values[i] = block.values[i].load(memory_order_relaxed);
+    }
+
+    return values;
+}
+
+} // namespace
+
+profiler::CounterBlock::CounterBlock() {
+    for (auto& v : values) {
+        v.store(0, memory_order_relaxed);
+    }
+
+    lock_guard<mutex> lock(blocks_mutex);
+    blocks.push_back(this);
+}
+
+profiler::CounterBlock::~CounterBlock() {
+    lock_guard<mutex> lock(blocks_mutex);
+
+    for (int i = 0; i < COUNTERS; i++) {
+        retired[i] += values[i].load(memory_order_relaxed);
+    }
+
+    blocks.erase(std::find(blocks.begin(), blocks.end(), this));
+}
+
+profiler::Counters profiler::counters() {
+    lock_guard<mutex> lock(blocks_mutex);
+    Counters totals = retired;
+
+    for (CounterBlock* block : blocks) {
+        for (int i = 0; i < COUNTERS; i++) {
+            totals[i] += block->values[i].load(memory_order_relaxed);
+        }
+    }
+
+    return totals;
+}
+
+profiler::Context::Context() : previous(current_context), thread_start(threadCounters()), thread_cpu_start(threadCpuSeconds()) {
+    for (auto& v : task_counters) {
+        v.store(0, memory_order_relaxed);
+    }
+
+    current_context = this;
+}
+
+profiler::Context::~Context() {
+    current_context = previous;
+}
+
+profiler::Counters profiler::Context::counters() const {
+    Counters values = threadCounters();
+
+    for (int i = 0; i < COUNTERS; i++) {
+        values[i] += task_counters[i].load(memory_order_relaxed) - thread_start[i];
+    }
+
+    return values;
+}
+
+double profiler::Context::cpuSeconds() const {
+    return threadCpuSeconds() - thread_cpu_start + task_cpu_nanoseconds.load(memory_order_relaxed) * 1e-9;
+}
+
+profiler::Context* profiler::currentContext() {
+    return current_context;
+}
+
+double profiler::contextCpuSeconds() {
+    return current_context != nullptr ? current_context->cpuSeconds() : cpuSeconds();
+}
+
+profiler::TaskScope::TaskScope(Context* context) : context(context), previous(current_context) {
+    if (context != nullptr) {
+        thread_start = threadCounters();
+        thread_cpu_start = threadCpuSeconds();
+        current_context = context;
+    }
+}
+
+profiler::TaskScope::~TaskScope() {
+    if (context != nullptr) {
+        Counters values = threadCounters();
+
+        for (int i = 0; i < COUNTERS; i++) {
+            context->task_counters[i].fetch_add(values[i] - thread_start[i], memory_order_relaxed);
+        }
+
+        context->task_cpu_nanoseconds.fetch_add((uint64_t)((threadCpuSeconds() - thread_cpu_start) * 1e9), memory_order_relaxed);
+        current_context = previous;
+    }
+}
+
+const char* profiler::phaseName(Phase phase) {
+    switch (phase) {
+    case LOAD: return "load";
+    case CDT_BUILD: return "cdt_build";
+    case SEARCH: return "search";
+    case EXPORT: return "export";
+    default: return "unknown";
+    }
+}
+
+const char* profiler::counterName(Counter counter) {
+    switch (counter) {
+    case CDT_COPIES: return "cdt_copies";
+    case ROLLBACKS: return "rollbacks";
+    case OBTUSE_TESTS: return "obtuse_tests";
+    case OBTUSE_INTEGER: return "obtuse_integer";
+    case OBTUSE_DOUBLE: return "obtuse_double";
+    case OBTUSE_INTERVAL: return "obtuse_interval";
+    case OBTUSE_EXACT: return "obtuse_exact";
+    case CANDIDATE_HITS: return "candidate_hits";
+    case CANDIDATE_MISSES: return "candidate_misses";
+    case MOVES_ACCEPTED: return "moves_accepted";
+    case MOVES_REJECTED: return "moves_rejected";
+    case PHEROMONE_UPDATES: return "pheromone_updates";
+    default: return nullptr;
+    }
+}
+
+const char* profiler::primitiveName(Primitive primitive) {
+    switch (primitive) {
+    case COUNT_OBTUSE: return "count_obtuse_triangles";
+    case CDT_COPY: return "cdt_copy";
+    case STRATEGY_GENERATION: return "strategy_generation";
+    default: return "unknown";
+    }
+}
+
+void profiler::reset() {
+    for (PrimitiveTimes& t : primitives) {
+        t.calls = 0;
+        t.nanoseconds = 0;
+    }
+
+    {
+        lock_guard<mutex> lock(blocks_mutex);
+
+        retired.fill(0);
+
+        for (CounterBlock* block : blocks) {
+            for (auto& v : block->values) {
+                v.store(0, memory_order_relaxed);
+            }
+        }
+    }
+
+    // Linux: "5" resets the high-water mark of the resident set (VmHWM)
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+
+    if (f != nullptr) {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+double profiler::cpuSeconds() {
+    timespec ts;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+double profiler::threadCpuSeconds() {
+    timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    return 0;
+}
+
+long profiler::peakRssKb() {
+    // VmHWM follows the resets of reset(), ru_maxrss is the peak since the start
+    ifstream status("/proc/self/status");
+    string line;
+
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return atol(line.c_str() + 6);
+        }
+    }
+
+    rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
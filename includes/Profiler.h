@@ -0,0 +1,232 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+//
+// Measurements of a run:
+//  - wall time, CPU time and peak RSS of its phases (always measured, into
+//    the times the caller passes),
+//  - calls and time of the hot primitives (polyg_bench: nothing is timed
+//    unless enabled),
+//  - event counters (CDT copies, insertions by strategy, predicate calls,
+//    moves, ...), compiled in with POLYG_STATS only. Every thread counts in
+//    its own block, so counting costs a plain increment.
+// The counters and the phase CPU times of a solve are taken in a Context:
+// those of the thread that runs it and of the pool tasks it starts, so the
+// instances solved at the same time (--batch) do not mix.
+//
+namespace profiler {
+
+enum Phase {
+    LOAD,
+    CDT_BUILD,
+    SEARCH,
+    EXPORT,
+    PHASES,
+};
+
+enum Primitive {
+    COUNT_OBTUSE,        // utils::countObtuseTriangles
+    CDT_COPY,            // local patch copied (and tried) by patch_obtuse_delta
+    STRATEGY_GENERATION, // steiner_stategies::generateSteinerPoint
+    PRIMITIVES,
+};
+
+// Slots of the insertions, one per steiner_stategies::Strategy
+const int STRATEGY_SLOTS = 8;
+
+enum Counter {
+    CDT_COPIES,        // local patches built by patch_obtuse_delta
+    ROLLBACKS,         // transactions undone
+    OBTUSE_TESTS,      // obtuse_predicates::obtuse_vertex
+    OBTUSE_INTEGER,    // tests decided in 128-bit integers
+    OBTUSE_DOUBLE,     // tests decided in doubles
+    OBTUSE_INTERVAL,   // tests decided on intervals
+    OBTUSE_EXACT,      // angles left to the exact kernel
+    CANDIDATE_HITS,    // SteinerCandidateCache deltas reused
+    CANDIDATE_MISSES,  // SteinerCandidateCache deltas evaluated
+    MOVES_ACCEPTED,    // SA steps and ACO cycles kept
+    MOVES_REJECTED,    // SA steps and ACO cycles undone
+    PHEROMONE_UPDATES, // pheromone values changed (ACO)
+    INSERTIONS,        // Steiner points inserted, + strategy
+    COUNTERS = INSERTIONS + STRATEGY_SLOTS,
+};
+
+typedef std::array<uint64_t, COUNTERS> Counters;
+
+struct PhaseTimes {
+    double wall_seconds = 0;
+    double cpu_seconds = 0; // of the solve (Context), of the process outside one
+    long peak_rss_kb = 0; // high-water mark of the process at the end of the phase
+};
+
+struct PrimitiveTimes {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> nanoseconds{0};
+};
+
+// Counters of one thread: written by it only, read by anyone
+struct CounterBlock {
+    std::atomic<uint64_t> values[COUNTERS];
+
+    CounterBlock();  // registered for counters()
+    ~CounterBlock(); // the values are kept once the thread ends
+};
+
+extern bool enabled;
+extern PrimitiveTimes primitives[PRIMITIVES];
+
+const char* phaseName(Phase phase);
+
+const char* primitiveName(Primitive primitive);
+
+const char* counterName(Counter counter); // nullptr for the insertion slots
+
+// Zeroes the primitives, the counters and the peak RSS of the process (where the system allows it)
+void reset();
+
+// CPU time of the process, all threads
+double cpuSeconds();
+
+// CPU time of the calling thread
+double threadCpuSeconds();
+
+long peakRssKb();
+
+// Totals of every thread
+Counters counters();
+
+inline CounterBlock& localCounters() {
+    thread_local CounterBlock block;
+    return block;
+}
+
+inline void count(Counter counter, uint64_t n = 1) {
+    std::atomic<uint64_t>& value = localCounters().values[counter];
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+//
+// Measurements of one solve, from its construction on the thread that runs
+// it: the counters and CPU time of that thread, plus what the pool tasks it
+// starts add when they finish (TaskScope). Nested contexts restore the
+// previous one.
+//
+class Context {
+public:
+    Context();
+    ~Context();
+
+    Counters counters() const;
+
+    double cpuSeconds() const;
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+private:
+    friend class TaskScope;
+
+    Context* previous;
+    Counters thread_start;
+    double thread_cpu_start;
+    std::atomic<uint64_t> task_counters[COUNTERS];
+    std::atomic<uint64_t> task_cpu_nanoseconds{0};
+};
+
+// Context of the calling thread, nullptr outside a solve
+Context* currentContext();
+
+// CPU time of the current context, of the process outside one
+double contextCpuSeconds();
+
+//
+// A pool task run for context on another thread: its counters and CPU time
+// are added to context at the end of the scope (nothing if context is null)
+//
+class TaskScope {
+public:
+    explicit TaskScope(Context* context);
+    ~TaskScope();
+
+    TaskScope(const TaskScope&) = delete;
+    TaskScope& operator=(const TaskScope&) = delete;
+
+private:
+    Context* context;
+    Context* previous;
+    Counters thread_start;
+    double thread_cpu_start = 0;
+};
+
+class PhaseScope {
+public:
+    explicit PhaseScope(PhaseTimes& times) : times(times), active(true) {
+        wall_start = std::chrono::steady_clock::now();
+        cpu_start = contextCpuSeconds();
+    }
+
+    ~PhaseScope() {
+        stop();
+    }
+
+    // Ends the phase before the end of the scope
+    void stop() {
+        if (active) {
+            times.wall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+            times.cpu_seconds += contextCpuSeconds() - cpu_start;
+            times.peak_rss_kb = peakRssKb();
+            active = false;
+        }
+    }
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+    PhaseTimes& times;
+    bool active;
+    std::chrono::steady_clock::time_point wall_start;
+    double cpu_start = 0;
+};
+
+class PrimitiveScope {
+public:
+    explicit PrimitiveScope(Primitive primitive) : primitive(primitive), active(enabled) {
+        if (active) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~PrimitiveScope() {
+        if (active) {
+            PrimitiveTimes& t = primitives[primitive];
+            t.calls.fetch_add(1, std::memory_order_relaxed);
+            t.nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        }
+    }
+
+    PrimitiveScope(const PrimitiveScope&) = delete;
+    PrimitiveScope& operator=(const PrimitiveScope&) = delete;
+
+private:
+    Primitive primitive;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace profiler
+
+//
+// Counting points, empty unless built with POLYG_STATS
+//
+#ifdef POLYG_STATS
+#define POLYG_COUNT(counter) profiler::count(profiler::counter)
+#define POLYG_COUNT_INSERTION(strategy) profiler::count((profiler::Counter)(profiler::INSERTIONS + (int)(strategy)))
+#else
+#define POLYG_COUNT(counter) ((void)0)
+#define POLYG_COUNT_INSERTION(strategy) ((void)0)
+#endif
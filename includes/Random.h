@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+//
+// Random numbers of the engines: every thread draws from its own stream
+// (xoshiro256++), so the draws of one thread never depend on what the others
+// do. A run is reproduced by seeding the stream of the thread that solves it
+// with the seed recorded for it (rng::seed); threads that are never seeded
+// get independent streams of a fresh process seed.
+//
+namespace rng {
+
+inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+class Generator {
+public:
+    typedef uint64_t result_type;
+
+    // Stream of a seed: the streams of different indices do not overlap in practice
+    explicit Generator(uint64_t seed = 0, uint64_t stream = 0) {
+        reseed(seed, stream);
+    }
+
+    void reseed(uint64_t seed, uint64_t stream = 0) {
+        uint64_t x = stream;
+        uint64_t y = seed ^ splitmix64(x);
+
+        for (uint64_t& word : s) {
+            word = splitmix64(y);
+        }
+    }
+
+    // Position in the stream, to continue it later (checkpoints)
+    std::array<uint64_t, 4> state() const {
+        return {s[0], s[1], s[2], s[3]};
+    }
+
+    void setState(const std::array<uint64_t, 4>& state) {
+        for (int i = 0; i < 4; i++) {
+            s[i] = state[i];
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+    }
+
+    // Uniform in [0, 1), all 53 bits of the mantissa
+    double uniform() {
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Uniform in [0, n), n > 0
+    uint64_t below(uint64_t n) {
+        return (uint64_t)(((unsigned __int128)(*this)() * n) >> 64);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t s[4];
+};
+
+// A seed from the system entropy and the clock
+inline uint64_t freshSeed() {
+    std::random_device device;
+    uint64_t x = ((uint64_t)device() << 32) ^ device() ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    return splitmix64(x);
+}
+
+// Seed of the threads that are never seeded, different in every process
+inline uint64_t processSeed() {
+    static const uint64_t seed = freshSeed();
+    return seed;
+}
+
+// Stream of the calling thread
+inline Generator& local() {
+    static std::atomic<uint64_t> threads{0};
+    thread_local Generator generator(processSeed(), threads.fetch_add(1));
+    return generator;
+}
+
+// Restarts the stream of the calling thread from seed
+inline void seed(uint64_t seed) {
+    local().reseed(seed);
+}
+
+} // namespace rng
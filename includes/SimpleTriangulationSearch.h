@@ -1,7 +1,9 @@
 // Standard C++
+#include <array>
 #include <gmp.h>
 #include <iostream>
 #include <map>
+#include <type_traits>
 #include <vector>
 
 // Macros and headers for CGAL
@@ -18,7 +20,11 @@
 
 // Support classes
 #include "JsonExporter.h"
+#include "Deadline.h"
 #include "JsonLoader.h"
+#include "ObtuseFaceWorklist.h"
+#include "Log.h"
+#include "Profiler.h"
 #include "graph_definitions.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
@@ -26,10 +32,13 @@
 // Namespaces
 using namespace std;
 
-template <typename T>
+template <class Traits>
 class SimpleTriangulationSearch {
+    // utils, steiner_strategies and the loader are built for the kernel of cgal_definitions.h
+    static_assert(std::is_same<typename Traits::CDT, CDT>::value, "Traits must match the kernel of this build (POLYG_EXACT_NT)");
+
 public:
-    vector<Point> triangulate(steiner_stategies::Strategy strategy, Graph& graph, JsonLoader& loader,  Polygon & boundaryPolygon) {
+    vector<Point> triangulate(steiner_stategies::Strategy strategy, Graph& graph, JsonLoader& loader,  Polygon & boundaryPolygon, Deadline& deadline) {
         int MAX_ITERATIONS = loader.getL();
         int obtuse_triangles_initial = 0;
         int obtuse_triangles_before = 0;
@@ -38,52 +47,47 @@ public:
         vector<Point> steinerPoints;
         CDT & cdt = *(graph.cdt);
 
-        cout << "# Max iterations: " << MAX_ITERATIONS << endl;
+        POLYG_LOG(INFO, "# Max iterations: " << MAX_ITERATIONS);
 
-        for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-            Point a = fit->vertex(0)->point();
-            Point b = fit->vertex(1)->point();
-            Point c = fit->vertex(2)->point();
+        obtuse_triangles_initial = utils::countObtuseTriangles(cdt);
 
-            if (utils::is_obtuse(a, b, c)) {
-                obtuse_triangles_initial++;
-            }
-        }
+        ObtuseFaceWorklist worklist(cdt);
+
+        // Under a budget: the fewest obtuse triangles seen, in case the search is stopped
+        BestSolution<CDT, Point> best(deadline.budgeted());
+        best.offer(obtuse_triangles_initial, cdt, steinerPoints);
 
-        for (int i = 1; i <= MAX_ITERATIONS; i++) {
+        for (int i = 1; i <= MAX_ITERATIONS && !deadline.expired(); i++) {
             int conflicts = 0;
 
-            obtuse_triangles_before = 0;
+            obtuse_triangles_before = utils::countObtuseTriangles(cdt);
             obtuse_triangles_after = 0;
 
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
-
-                if (utils::is_obtuse(a, b, c)) {
-                    obtuse_triangles_before++;
-                }
-            }
-
-            std::vector<CDT::Face_handle> finite_faces;
-
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
+            // The obtuse faces, most severe first, kept by their vertices
+            std::vector<std::array<CDT::Vertex_handle, 3>> finite_faces = worklist.take_round();
 
             //
             // Optimization algorithm
             //
 
-            for (auto fit : finite_faces) {
+            for (auto& face_vertices : finite_faces) {
+                CDT::Face_handle fit;
+
+                if (deadline.expired()) {
+                    break;
+                }
+
+                if (!cdt.is_face(face_vertices[0], face_vertices[1], face_vertices[2], fit)) {
+                    continue; // split by an earlier insertion
+                }
+
                 Point a = fit->vertex(0)->point();
                 Point b = fit->vertex(1)->point();
                 Point c = fit->vertex(2)->point();
 
                 bool result = utils::is_obtuse(a, b, c);
 
-                cout << "Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << endl;
+                POLYG_LOG(DEBUG, "Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result);
 
                 conflicts++;
 
@@ -91,7 +95,7 @@ public:
                     if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
                         int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
                         if (i == -1) {
-                            cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
+                            POLYG_LOG(ERROR, "CRITICAL ERROR: find_obtuse_angle failed ");
                             exit(1);
                         }
 
@@ -107,9 +111,9 @@ public:
                         }
                     }
 
-                    Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
+                    steiner_stategies::SteinerPoint s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
 
-                    if (s != nullptr) {
+                    if (s) {
                         if (boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
                             // cout << "Inserting ... " << s << endl;
                             if (strategy == steiner_stategies::Strategy::POLYGON) {
@@ -119,33 +123,39 @@ public:
                                 cdt.insert_no_flip(*s);
                             }
                             steinerPoints.emplace_back(*s);
+                            POLYG_COUNT_INSERTION(strategy);
                         } else {
                             // cout << "Steiner point ignored  - outside the boundaries " << endl;
                         }
-
-                        delete s;
                     }
                 }
             }
 
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
+            // Faces the sweep did not fix stay for the next one
+            worklist.requeue(finite_faces);
 
-                if (utils::is_obtuse(a, b, c)) {
-                    obtuse_triangles_after++;
-                }
-            }
+            obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+
+            best.offer(obtuse_triangles_after, cdt, steinerPoints);
 
-            cout << " ### Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before << endl;
+            POLYG_LOG(INFO, " ### Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before);
             if (obtuse_triangles_after >= obtuse_triangles_before || conflicts == 0) {
                 break;
             }
         }
 
-        cout << "Initial obtuse triangles: " << obtuse_triangles_initial << endl;
-        cout << "Total obtuse triangles: " << obtuse_triangles_after << endl;
+        if (deadline.expired()) {
+            POLYG_LOG(INFO, "# Search stopped: time budget or cancellation");
+        }
+
+        obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+
+        if (best.restore(obtuse_triangles_after, cdt, steinerPoints)) {
+            obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+        }
+
+        POLYG_LOG(INFO, "Initial obtuse triangles: " << obtuse_triangles_initial);
+        POLYG_LOG(INFO, "Total obtuse triangles: " << obtuse_triangles_after);
 
         return steinerPoints;
     }
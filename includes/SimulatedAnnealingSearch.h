@@ -1,8 +1,11 @@
 // Standard C++
+#include <array>
 #include <cmath>
 #include <gmp.h>
 #include <iostream>
 #include <map>
+#include <optional>
+#include <type_traits>
 #include <vector>
 
 // Macros and headers for CGAL
@@ -19,7 +22,14 @@
 
 // Support classes
 #include "JsonExporter.h"
+#include "Checkpoint.h"
+#include "Deadline.h"
 #include "JsonLoader.h"
+#include "ObtuseFaceWorklist.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "SteinerCandidateCache.h"
 #include "graph_definitions.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
@@ -27,8 +37,11 @@
 // Namespaces
 using namespace std;
 
-template <typename U>
+template <class Traits>
 class SimulatedAnnealingSearch {
+    // utils, steiner_strategies and the loader are built for the kernel of cgal_definitions.h
+    static_assert(std::is_same<typename Traits::CDT, CDT>::value, "Traits must match the kernel of this build (POLYG_EXACT_NT)");
+
 private:
     float calculateEnergy(float alpha, float beta, int obtuse_triangles, int steiner_points) {
         return alpha * obtuse_triangles + beta * steiner_points;
@@ -38,11 +51,25 @@ private:
         return exp(-(e2 - e1) / T);
     }
 
+    SearchState searchState(CDT& cdt, const vector<Point>& steinerPoints, int iteration, float T, const rng::Generator& generator) {
+        SearchState state;
+
+        state.method = "sa";
+        state.iteration = iteration;
+        state.temperature = T;
+        state.rng = generator.state();
+        state.steiner_vertices = Checkpoint::idsOf(cdt, steinerPoints);
+
+        return state;
+    }
+
 public:
-    vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon, float alpha, float beta) {
+    vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon, float alpha, float beta, Deadline& deadline, Checkpoint& checkpoint) {
         vector<Point> steinerPoints;
         CDT& cdt = *(graph.cdt);
 
+        rng::Generator& generator = rng::local(); // stream of the solving thread, seeded by the caller
+
         int MAX_ITERATIONS = loader.getL();
         int obtuse_triangles_initial = utils::countObtuseTriangles(cdt);
         int obtuse_triangles_before = 0;
@@ -50,13 +77,33 @@ public:
         
         float T = 1; // temperature
 
-        cout << "# Max iterations: " << MAX_ITERATIONS << endl;
+        ObtuseFaceWorklist worklist(cdt);
+        SteinerCandidateCache cache(graph, boundaryPolygon);
+
+        POLYG_LOG(INFO, "# Max iterations: " << MAX_ITERATIONS);
 
-        float E = calculateEnergy(alpha, beta, obtuse_triangles_initial, steinerPoints.size());
         int i = 0;
 
-        while (T >= 0) {
-            cout << " *** Current Energy: " << E << ", T = " << T << endl;
+        // Restored run: the triangulation is the checkpoint's, the search goes on from its state
+        if (checkpoint.resume) {
+            const SearchState& state = *checkpoint.resume;
+
+            steinerPoints = Checkpoint::pointsOf(cdt, state.steiner_vertices);
+            T = state.temperature;
+            i = state.iteration;
+            generator.setState(state.rng);
+
+            POLYG_LOG(INFO, "# Resumed at iteration " << i << ", T = " << T);
+        }
+
+        float E = calculateEnergy(alpha, beta, obtuse_triangles_initial, steinerPoints.size());
+
+        // Under a budget: the lowest energy seen, since uphill moves may be the last ones
+        BestSolution<CDT, Point> best(deadline.budgeted());
+        best.offer(E, cdt, steinerPoints);
+
+        while (T >= 0 && !deadline.expired()) {
+            POLYG_LOG(INFO, " *** Current Energy: " << E << ", T = " << T);
 
             int conflicts = 0;
 
@@ -66,42 +113,47 @@ public:
             float E_current = calculateEnergy(alpha, beta, obtuse_triangles_before, steinerPoints.size());
             float E_next = 0;
 
-            std::vector<CDT::Face_handle> finite_faces;
-
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
+            // The obtuse faces, most severe first. Faces are kept by their
+            // vertices: an insertion (or a rolled back trial that crossed a
+            // constraint) may destroy the face handles
+            std::vector<std::array<CDT::Vertex_handle, 3>> finite_faces = worklist.take_round();
 
             //
             // Optimization algorithm
             //
 
-            for (auto fit : finite_faces) {
+            for (auto& face_vertices : finite_faces) {
+                CDT::Face_handle fit;
+
+                if (deadline.expired()) {
+                    break;
+                }
+
+                if (!cdt.is_face(face_vertices[0], face_vertices[1], face_vertices[2], fit)) {
+                    continue; // split by an earlier insertion
+                }
+
                 Point a = fit->vertex(0)->point();
                 Point b = fit->vertex(1)->point();
                 Point c = fit->vertex(2)->point();
 
                 bool result = utils::is_obtuse(a, b, c);
 
-                cout << " - Iteration: " << i << " Temperature: " << T << ": Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << ", obtuse triangles: " << obtuse_triangles_before << endl;
+                POLYG_LOG(DEBUG, " - Iteration: " << i << " Temperature: " << T << ": Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << ", obtuse triangles: " << obtuse_triangles_before);
 
                 conflicts++;
 
                 if (result) {
                     // ---------------------------------------------------------
                     int n = strategies.size();
-                    int N = rand() % n;
+                    int N = (int)generator.below(n);
 
                     steiner_stategies::Strategy& selected_strategy = strategies[N];
 
-                    CDT cdt_copy = cdt;
-                    Graph graph_copy;
-                    graph_copy.cdt = &cdt_copy;
-
                     if (selected_strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
                         int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
                         if (i == -1) {
-                            cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
+                            POLYG_LOG(ERROR, "CRITICAL ERROR: find_obtuse_angle failed ");
                             exit(1);
                         }
 
@@ -117,27 +169,45 @@ public:
                         }
                     }
 
-                    Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, selected_strategy);
+                    // POLYGON adds constraints while generating its point, so its trial runs
+                    // in place and is always rolled back: an accepted point is inserted
+                    // alone, without the constraints of the trial. The other points come
+                    // from the cache, are tried on a local patch and inserted once accepted
+                    bool in_place = selected_strategy == steiner_stategies::Strategy::POLYGON;
+                    SteinerCandidateCache::Candidate* candidate = nullptr;
+                    std::optional<Point> s;
+
+                    if (in_place) {
+                        cdt.begin_transaction();
+
+                        s = steiner_stategies::generateSteinerPoint(graph, a, b, c, selected_strategy).point;
+                    } else {
+                        candidate = &cache.candidate(face_vertices, selected_strategy);
+
+                        if (candidate->generated) {
+                            s = candidate->point;
+                        }
+                    }
 
                     E_next = E_current;
 
-                    if (s != nullptr) {
-                        if (boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
+                    if (s) {
+                        bool inserted = false;
+                        int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+
+                        if (in_place && boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
                             // cout << "Inserting ... " << s << endl;
-                            if (selected_strategy == steiner_stategies::Strategy::POLYGON) {
-                                cdt_copy.insert(*s);
-                            } else {
-                                cdt_copy.insert_no_flip(*s);
-                            }
+                            cdt.insert(*s);
+                            copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+                            inserted = true;
+                        } else if (!in_place && candidate->inside) {
+                            copy_obtuse_triangles_after += cache.delta(*candidate, fit);
+                            inserted = true;
                         }
-
-                        int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy);
                         
                         E_next = calculateEnergy(alpha, beta, copy_obtuse_triangles_after, steinerPoints.size() + 1);
 
-                        cout << "\t";
-                        steiner_stategies::printStrategy(selected_strategy);
-                        cout << " - New energy: " << E_next << " - Method succeeded " << copy_obtuse_triangles_after << endl;
+                        POLYG_LOG(TRACE, "\t" << steiner_stategies::strategyLabel(selected_strategy) << " - New energy: " << E_next << " - Method succeeded " << copy_obtuse_triangles_after);
 
                         // --------------------------------------------------------- energy 
                         bool accept_strategy = false;
@@ -145,8 +215,8 @@ public:
                         if (E_next < E_current) {
                             accept_strategy = true;
                         } else {
-                            float prob = exp(-(E_next-E_current)/T);
-                            float dice = 0.01f*(rand()%100);
+                            double prob = exp(-(E_next-E_current)/T);
+                            double dice = generator.uniform();
 
                             if (dice < prob) {
                                 accept_strategy = true;
@@ -154,44 +224,51 @@ public:
                         }
 
                         if (accept_strategy) {
-                            cout << "* Energy: " << E_current << " to " << E_next << " - Strategy selected: ";
+                            POLYG_COUNT(MOVES_ACCEPTED);
 
-                            steiner_stategies::printStrategy(selected_strategy);
+                            POLYG_LOG(DEBUG, "* Energy: " << E_current << " to " << E_next << " - Strategy selected: " << steiner_stategies::strategyLabel(selected_strategy));
 
-                            cout << endl;
-
-                            Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, selected_strategy);
-
-                            if (s != nullptr && boundaryPolygon.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE) {
-                                if (selected_strategy == steiner_stategies::Strategy::POLYGON) {
+                            if (inserted) {
+                                if (in_place) {
+                                    cdt.rollback();
                                     cdt.insert(*s);
                                 } else {
-                                    cdt.insert_no_flip(*s);
+                                    cdt.insert_no_flip(*s, fit);
                                 }
                                 steinerPoints.emplace_back(*s);
-                            } else {
+                                POLYG_COUNT_INSERTION(selected_strategy);
+                            } else if (in_place) {
                                 // cout << "Steiner point ignored  - outside the boundaries " << endl;
+                                cdt.rollback();
                             }
-
-                            delete s;
                         } else {
-                            cout << "* Energy: " << E_current << " to " << E_next << " - Strategy rejetced. " << endl;
+                            POLYG_COUNT(MOVES_REJECTED);
 
-                            if (s != nullptr) {
-                                delete s;
+                            POLYG_LOG(DEBUG, "* Energy: " << E_current << " to " << E_next << " - Strategy rejetced. ");
+
+                            if (in_place) {
+                                cdt.rollback();
                             }
                         }
                     } else {
-                        cout << "\t";
-                        steiner_stategies::printStrategy(selected_strategy);
-                        cout << " - New energy: " << E_next << " - Method failed    " << endl;
+                        if (in_place) {
+                            cdt.rollback();
+                        }
+
+                        POLYG_LOG(TRACE, "\t" << steiner_stategies::strategyLabel(selected_strategy) << " - New energy: " << E_next << " - Method failed    ");
                     }
                 }
             }
 
+            // Faces the sweep did not fix stay for the next one
+            worklist.requeue(finite_faces);
+            cache.prune();
+
             obtuse_triangles_after = utils::countObtuseTriangles(cdt);
 
-            cout << " ### Temperature: " << T << " - Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before << endl;
+            best.offer(calculateEnergy(alpha, beta, obtuse_triangles_after, steinerPoints.size()), cdt, steinerPoints);
+
+            POLYG_LOG(INFO, " ### Temperature: " << T << " - Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before);
             // if (obtuse_triangles_after >= obtuse_triangles_before || conflicts == 0 || obtuse_triangles_after == 0) {
             //     break;
             // }
@@ -203,17 +280,36 @@ public:
             T = T - 1.0f / MAX_ITERATIONS;
 
             i++;
+
+            if (checkpoint.due()) {
+                checkpoint.save(cdt, searchState(cdt, steinerPoints, i, T, generator));
+            }
+        }
+
+        if (deadline.expired()) {
+            POLYG_LOG(INFO, "# Search stopped: time budget or cancellation");
+
+            // Where the search stopped (before the best state is put back), to go on later
+            if (checkpoint.enabled()) {
+                checkpoint.save(cdt, searchState(cdt, steinerPoints, i, T, generator));
+            }
+        }
+
+        obtuse_triangles_after = utils::countObtuseTriangles(cdt);
+
+        if (best.restore(calculateEnergy(alpha, beta, obtuse_triangles_after, steinerPoints.size()), cdt, steinerPoints)) {
+            obtuse_triangles_after = utils::countObtuseTriangles(cdt);
         }
 
-        cout << "***********************************************************************" << endl;
-        cout << " - Initial obtuse triangles: " << obtuse_triangles_initial << endl;
-        cout << " - Total obtuse triangles  : " << obtuse_triangles_after << endl;
-        cout << " - Total steiner points    : " << steinerPoints.size() << endl;
-        cout << " - Energy - Initial        : " << alpha*obtuse_triangles_initial << endl;
-        cout << " - Energy - Final          : " << alpha*obtuse_triangles_after + beta*steinerPoints.size() << endl;
-        cout << " - Alpha                   : " << alpha << endl;
-        cout << " - Beta                    : " << beta << endl;
-        cout << "***********************************************************************" << endl;
+        POLYG_LOG(INFO, "***********************************************************************");
+        POLYG_LOG(INFO, " - Initial obtuse triangles: " << obtuse_triangles_initial);
+        POLYG_LOG(INFO, " - Total obtuse triangles  : " << obtuse_triangles_after);
+        POLYG_LOG(INFO, " - Total steiner points    : " << steinerPoints.size());
+        POLYG_LOG(INFO, " - Energy - Initial        : " << alpha*obtuse_triangles_initial);
+        POLYG_LOG(INFO, " - Energy - Final          : " << alpha*obtuse_triangles_after + beta*steinerPoints.size());
+        POLYG_LOG(INFO, " - Alpha                   : " << alpha);
+        POLYG_LOG(INFO, " - Beta                    : " << beta);
+        POLYG_LOG(INFO, "***********************************************************************");
 
         return steinerPoints;
     }
@@ -0,0 +1,377 @@
+// Standard C++
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "Checkpoint.h"
+#include "Deadline.h"
+#include "JsonExporter.h"
+#include "JsonLoader.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "Solver.h"
+#include "graph_definitions.h"
+#include "search_engines.h"
+#include "steiner_strategies.h"
+#include "utils.hpp"
+
+// Namespaces
+using namespace std;
+
+namespace {
+
+// Statistics of the run next to the solution: output.json -> output.stats.json
+void saveStats(const char* outputfile, const SolveReport& report, JsonLoader& loader) {
+    boost::property_tree::ptree pt_root = statsTree(report);
+    boost::property_tree::ptree pt_parameters;
+
+    pt_root.put("instance_uid", loader.getInstance());
+
+    pt_parameters.put("L", loader.getL());
+    pt_parameters.put("threads", loader.getThreads());
+    pt_parameters.put("alpha", loader.alpha);
+    pt_parameters.put("beta", loader.beta);
+    pt_parameters.put("xi", loader.xi);
+    pt_parameters.put("psi", loader.psi);
+    pt_parameters.put("lambda", loader.lambda);
+    pt_parameters.put("kappa", loader.kappa);
+
+    pt_root.add_child("parameters", pt_parameters);
+
+    string statsfile = std::filesystem::path(outputfile).replace_extension(".stats.json").string();
+
+    POLYG_LOG(INFO, "Saving statistics ... " << statsfile);
+    boost::property_tree::write_json(statsfile, pt_root);
+}
+
+} // namespace
+
+boost::property_tree::ptree statsTree(const SolveReport& report) {
+    boost::property_tree::ptree pt_root;
+
+    pt_root.put("input", report.input);
+    pt_root.put("method", report.method);
+    pt_root.put("seed", report.seed);
+    pt_root.put("time_limit", report.time_limit);
+    pt_root.put("interrupted", report.interrupted);
+
+    if (!report.resume.empty()) {
+        pt_root.put("resumed_from", report.resume);
+    }
+    pt_root.put("obtuse_initial", report.obtuse_initial);
+    pt_root.put("obtuse_final", report.obtuse_final);
+    pt_root.put("steiner_points", report.steiner_points);
+
+    if (report.has_energy) {
+        pt_root.put("energy", report.energy);
+    }
+
+    boost::property_tree::ptree pt_phases;
+    long peak_rss_kb = 0;
+
+    for (int i = 0; i < profiler::PHASES; i++) {
+        const profiler::PhaseTimes& t = report.phases[i];
+        boost::property_tree::ptree pt_phase;
+
+        pt_phase.put("wall_seconds", t.wall_seconds);
+        pt_phase.put("cpu_seconds", t.cpu_seconds);
+        pt_phase.put("peak_rss_kb", t.peak_rss_kb);
+
+        pt_phases.add_child(profiler::phaseName((profiler::Phase)i), pt_phase);
+
+        peak_rss_kb = std::max(peak_rss_kb, t.peak_rss_kb);
+    }
+
+    pt_root.put("peak_rss_kb", peak_rss_kb);
+    pt_root.add_child("phases", pt_phases);
+
+#ifdef POLYG_STATS
+    boost::property_tree::ptree pt_counters;
+    boost::property_tree::ptree pt_insertions;
+
+    for (int i = 0; i < profiler::INSERTIONS; i++) {
+        pt_counters.put(profiler::counterName((profiler::Counter)i), report.counters[i]);
+    }
+
+    for (int s = 0; s < profiler::STRATEGY_SLOTS && s < steiner_stategies::Strategy::NONE; s++) {
+        pt_insertions.put(steiner_stategies::strategyName((steiner_stategies::Strategy)s), report.counters[profiler::INSERTIONS + s]);
+    }
+
+    pt_counters.add_child("insertions", pt_insertions);
+    pt_root.add_child("counters", pt_counters);
+#endif
+
+    return pt_root;
+}
+
+int solve(const char* inputfile, const char* outputfile, SolveReport& report, CDT& cdt) {
+    POLYG_LOG(INFO, "Input file: " << inputfile);
+    POLYG_LOG(INFO, "Output file: " << outputfile);
+
+    // Counters and CPU times of this instance only, whatever runs beside it
+    profiler::Context profile;
+
+    // Load file:
+    profiler::PhaseScope load_phase(report.phases[profiler::LOAD]);
+
+    JsonLoader loader;
+
+    loader.load(inputfile);
+
+    load_phase.stop();
+
+    JsonExporter exporter(loader.getInstance(), loader.getThreads());
+
+    loader.print();
+
+    report.method = loader.getMethod();
+
+    // Same seed, same run: the seed is in the statistics and the batch summary
+    if (!report.fixed_seed) {
+        report.seed = loader.getSeed() ? *loader.getSeed() : rng::freshSeed();
+    }
+
+    rng::seed(report.seed);
+
+    POLYG_LOG(INFO, "Seed: " << report.seed);
+
+    // Anytime mode: the budget counts from the start of the run, the search
+    // gets what the load left of it
+    if (report.time_limit <= 0) {
+        report.time_limit = loader.getTimeLimit();
+    }
+
+    Deadline deadline(report.time_limit > 0 ? std::max(report.time_limit - report.phases[profiler::LOAD].wall_seconds, 1e-9) : 0);
+
+    if (deadline.budgeted()) {
+        POLYG_LOG(INFO, "Time limit: " << report.time_limit << " s");
+    }
+
+    profiler::PhaseScope build_phase(report.phases[profiler::CDT_BUILD]);
+
+    Checkpoint checkpoint = report.checkpoint.empty() ? Checkpoint() : Checkpoint(report.checkpoint, report.checkpoint_interval);
+
+    const vector<Point>& points = loader.getPoints();
+    const std::vector<int>& boundary_constraints = loader.getRegionBoundaries();
+
+    if (!report.resume.empty()) {
+        //
+        // Triangulation of the checkpoint, and the search state to continue from
+        //
+        SearchState state = Checkpoint::restore(report.resume.c_str(), cdt);
+
+        if (state.method != report.method) {
+            throw runtime_error("checkpoint " + report.resume + " is of method " + state.method + ", not " + report.method);
+        }
+
+        report.seed = state.seed;
+        checkpoint.resume = state;
+
+        for (const Point& p : points) {
+            if (cdt.vertex_at(p) == Vertex_handle()) {
+                throw runtime_error("checkpoint " + report.resume + " is not of this instance");
+            }
+        }
+
+        POLYG_LOG(INFO, "Resumed from " << report.resume << " at iteration " << state.iteration << ", seed " << report.seed);
+    } else {
+        //
+        // Add vertices to graph (duplicate points share one)
+        //
+        std::vector<Vertex_handle> input_vertices;
+        input_vertices.reserve(points.size());
+
+        for (const Point& p : points) {
+            input_vertices.push_back(cdt.insert(p));
+        }
+
+        //
+        // Add edges to graph
+        //
+        const std::vector<std::pair<int, int>>& constraints = loader.getConstraints();
+
+        for (const auto& constraint : constraints) {
+            cdt.insert_constraint(input_vertices[constraint.first], input_vertices[constraint.second]);
+        }
+
+        //
+        // Add boundaries as edges to graph
+        //
+        for (size_t i = 0, j = 1; i < boundary_constraints.size() && j < boundary_constraints.size(); i++, j++) {
+            cdt.insert_constraint(input_vertices[boundary_constraints[i]], input_vertices[boundary_constraints[j]]);
+        }
+
+        cdt.insert_constraint(input_vertices[boundary_constraints[boundary_constraints.size() - 1]], input_vertices[boundary_constraints[0]]);
+    }
+
+    checkpoint.seed = report.seed;
+
+    //
+    // Create a polygon for the boundary
+    //
+    Polygon boundaryPolygon;
+
+    for (size_t i = 0; i < boundary_constraints.size(); i++) {
+        boundaryPolygon.push_back(points[boundary_constraints[i]]);
+    }
+
+    build_phase.stop();
+
+    // CGAL::draw(cdt);
+
+    //
+    // Triangulation
+    //
+    profiler::PhaseScope search_phase(report.phases[profiler::SEARCH]);
+
+    Graph graph;
+    graph.cdt = &cdt;
+
+    report.obtuse_initial = utils::countObtuseTriangles(cdt);
+
+    vector<Point> steinerPoints;
+
+    if (loader.getMethod() == "legacy") {
+        SimpleTriangulationSearch<SearchTraits> triangulator;
+
+        steiner_stategies::Strategy strategy = steiner_stategies::Strategy::PROJECTION;
+        steinerPoints = triangulator.triangulate(strategy, graph, loader, boundaryPolygon, deadline);
+    } else if (loader.getMethod() == "local") {
+        LocalSearch<SearchTraits> triangulator;
+
+        vector<steiner_stategies::Strategy> strategies;
+
+        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
+        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
+        strategies.push_back(steiner_stategies::Strategy::POLYGON);
+        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
+        strategies.push_back(steiner_stategies::Strategy::BISECTION);
+
+        steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, deadline);
+    } else if (loader.getMethod() == "sa") {
+        SimulatedAnnealingSearch<SearchTraits> triangulator;
+
+        vector<steiner_stategies::Strategy> strategies;
+
+        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
+        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
+        strategies.push_back(steiner_stategies::Strategy::POLYGON);
+        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
+        // strategies.push_back(steiner_stategies::Strategy::BISECTION);
+
+
+        float alpha = loader.alpha;
+        float beta = loader.beta;
+
+        POLYG_LOG(INFO, "Alpha: " << alpha);
+        POLYG_LOG(INFO, "Beta: " << beta);
+
+        steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta, deadline, checkpoint);
+    } else if (loader.getMethod() == "ant") {
+        AntColonySearch<SearchTraits> triangulator;
+
+        vector<steiner_stategies::Strategy> strategies;
+
+        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
+        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
+        strategies.push_back(steiner_stategies::Strategy::POLYGON);
+        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
+        // strategies.push_back(steiner_stategies::Strategy::BISECTION);
+
+
+        float alpha = loader.alpha;
+        float beta = loader.beta;
+
+        POLYG_LOG(INFO, "Alpha: " << alpha);
+        POLYG_LOG(INFO, "Beta: " << beta);
+
+        steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta, deadline, checkpoint);
+
+    } else {
+        POLYG_LOG(ERROR, "Unknown method of search ");
+        return -1;
+    }
+
+    search_phase.stop();
+
+    // Stopped early: the triangulation is still valid (and the best one kept), exported as usual
+    report.interrupted = deadline.expired();
+
+    //
+    // Export
+    //
+    profiler::PhaseScope export_phase(report.phases[profiler::EXPORT]);
+
+    // Index of every vertex in the solution: the instance index of an input
+    // point (the first one of duplicates), then the Steiner points (every
+    // other vertex, constraint intersections included) in id order
+    std::vector<Vertex_handle> vertices(cdt.number_of_vertices());
+    std::vector<int> solution_index(vertices.size(), -1);
+
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        vertices[vit->id()] = vit;
+    }
+
+    // Looked up in the final triangulation: the search may have replaced it
+    // with a copy (BestSolution::restore), no handle from before is valid
+    for (size_t i = 0; i < points.size(); i++) {
+        Vertex_handle v = cdt.vertex_at(points[i]);
+
+        if (v == Vertex_handle()) {
+            throw runtime_error("input point " + std::to_string(i) + " is missing from the triangulation");
+        }
+
+        int& index = solution_index[v->id()];
+        index = index < 0 ? (int)i : index;
+    }
+
+    for (size_t id = 0; id < vertices.size(); id++) {
+        if (solution_index[id] < 0) {
+            solution_index[id] = (int)(points.size() + exporter.steiner_points.size());
+            exporter.steiner_points.push_back(vertices[id]->point());
+        }
+    }
+
+    exporter.edges.reserve(cdt.number_of_vertices() * 3);
+
+    for (auto edge = cdt.finite_edges_begin(); edge != cdt.finite_edges_end(); ++edge) {
+        Vertex_handle v1 = edge->first->vertex(cdt.cw(edge->second));
+        Vertex_handle v2 = edge->first->vertex(cdt.ccw(edge->second));
+
+        exporter.edges.emplace_back(solution_index[v1->id()], solution_index[v2->id()]);
+    }
+
+    // exporter.print();
+
+    // Save JSON
+    POLYG_LOG(INFO, "Saving to file ... " << outputfile);
+    exporter.save(outputfile);
+
+    export_phase.stop();
+
+    report.obtuse_final = utils::countObtuseTriangles(cdt);
+    report.steiner_points = (int)exporter.steiner_points.size();
+
+    if (report.method == "sa" || report.method == "ant") {
+        report.has_energy = true;
+        report.energy = loader.alpha * report.obtuse_final + loader.beta * report.steiner_points;
+    }
+
+    report.counters = profile.counters();
+
+#ifdef POLYG_STATS
+    saveStats(outputfile, report, loader);
+#endif
+
+    return 0;
+}
+
@@ -0,0 +1,57 @@
+#pragma once
+
+// Macros for CGAL
+#include "cgal_definitions.h"
+
+// Macros and headers for boost
+#include "boost_definitions.h"
+
+// Standard C++
+#include <cstdint>
+#include <string>
+
+// Support classes
+#include "Profiler.h"
+
+// Namespaces
+using namespace std;
+
+//
+// Outcome of one instance, for the batch summary
+//
+struct SolveReport {
+    string input;
+    string output;
+    string method;
+    string status = "ok";
+    double seconds = 0;
+    int obtuse_initial = 0;
+    int obtuse_final = 0;
+    int steiner_points = 0;
+    bool has_energy = false;
+    float energy = 0;
+    uint64_t seed = 0;       // seed of the random choices: given when fixed_seed, recorded by solve
+    bool fixed_seed = false; // otherwise parameters.seed of the instance, or a fresh one
+    double time_limit = 0;   // seconds for the run, 0: parameters.time_limit of the instance (if any)
+    bool interrupted = false; // the search was stopped by the time limit or a cancellation
+    string checkpoint;        // file of the periodic checkpoints of sa and ant, none if empty
+    double checkpoint_interval = 0;
+    string resume;            // checkpoint to continue from instead of building the triangulation
+    profiler::PhaseTimes phases[profiler::PHASES];
+    profiler::Counters counters = {}; // events of this instance (POLYG_STATS)
+};
+
+//
+// One instance from file to file: load, CDT build, search, export (each
+// phase timed into the report). The random stream of the calling thread is
+// seeded for the run (see SolveReport::seed). Under a time limit the search
+// stops in time (or when cancelled, see Deadline) and its best triangulation
+// is exported. Long searches can be checkpointed, and resumed from their
+// checkpoint (see Checkpoint). The triangulation is left in cdt. Built with
+// POLYG_STATS, the statistics of the run are written next to the solution
+// (output.stats.json). Returns -1 for an unknown method.
+//
+int solve(const char* inputfile, const char* outputfile, SolveReport& report, CDT& cdt);
+
+// Result, phases and counters of a report (the statistics file, polyg_bench)
+boost::property_tree::ptree statsTree(const SolveReport& report);
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include "Profiler.h"
+#include "cgal_definitions.h"
+#include "graph_definitions.h"
+#include "steiner_strategies.h"
+#include "triangulation_configuration.h"
+
+//
+// Steiner candidates per face and strategy: the generated point, whether it
+// lies inside the boundary, and the change of the number of obtuse faces if
+// it were inserted without flips. The point depends on the three vertices
+// only, so it is kept as long as the face exists; the delta depends on the
+// faces around the point, so it is reused while their modification stamps
+// are older than the evaluation. POLYGON is never cached: generating its
+// point adds constraints to the triangulation.
+//
+class SteinerCandidateCache {
+public:
+    typedef std::array<CDT::Vertex_handle, 3> Face_vertices;
+
+    struct Candidate {
+        Face_vertices face;
+        bool generated = false; // the strategy produced a point
+        Point point;
+        bool inside = false; // strictly inside the boundary
+        bool evaluated = false;
+        int delta = 0;
+        unsigned long stamp = 0; // modification stamp of the evaluation
+    };
+
+    SteinerCandidateCache(Graph& graph, Polygon& boundary) : graph(graph), boundary(boundary) {
+    }
+
+    // Candidate of the strategy for the face (generated on first use)
+    Candidate& candidate(const Face_vertices& v, steiner_stategies::Strategy strategy) {
+        Candidate& entry = candidates[key(v, strategy)];
+
+        if (entry.face[0] == CDT::Vertex_handle()) {
+            Point a = v[0]->point();
+            Point b = v[1]->point();
+            Point c = v[2]->point();
+
+            steiner_stategies::SteinerPoint s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
+
+            store(entry, v, s);
+        }
+
+        return entry;
+    }
+
+    // Generates at once the missing candidates of the strategies for the face,
+    // sharing the geometry of the triangle (POLYGON is skipped)
+    void prepare(const Face_vertices& v, const std::vector<steiner_stategies::Strategy>& strategies) {
+        std::vector<steiner_stategies::Strategy> missing;
+
+        for (steiner_stategies::Strategy strategy : strategies) {
+            if (strategy != steiner_stategies::Strategy::POLYGON && candidates.count(key(v, strategy)) == 0) {
+                missing.push_back(strategy);
+            }
+        }
+
+        if (missing.empty()) {
+            return;
+        }
+
+        steiner_stategies::TriangleGeometry geometry = steiner_stategies::triangleGeometry(v[0]->point(), v[1]->point(), v[2]->point());
+        std::vector<steiner_stategies::SteinerPoint> points = steiner_stategies::generateSteinerPoints(graph, geometry, missing);
+
+        for (steiner_stategies::SteinerPoint& s : points) {
+            store(candidates[key(v, s.strategy)], v, s);
+        }
+    }
+
+    // Whether the delta of c is still valid; locates its point (hint: a face nearby)
+    bool is_current(Candidate& c, CDT::Face_handle hint, CDT::Locate_type& lt, CDT::Face_handle& loc, int& li) {
+        CDT& cdt = *(graph.cdt);
+
+        loc = cdt.locate(c.point, lt, li, hint);
+
+        if (c.evaluated && cdt.patch_stamp(loc, LOCAL_PATCH_RINGS) <= c.stamp) {
+            POLYG_COUNT(CANDIDATE_HITS);
+            return true;
+        }
+
+        POLYG_COUNT(CANDIDATE_MISSES);
+        return false;
+    }
+
+    void set_delta(Candidate& c, int delta) {
+        c.delta = delta;
+        c.evaluated = true;
+        c.stamp = graph.cdt->modification_stamp();
+    }
+
+    // Obtuse delta of inserting the point of c without flips
+    int delta(Candidate& c, CDT::Face_handle hint) {
+        CDT& cdt = *(graph.cdt);
+        CDT::Locate_type lt;
+        CDT::Face_handle loc;
+        int li;
+
+        if (!is_current(c, hint, lt, loc, li)) {
+            int d = 0;
+
+            if (!cdt.patch_obtuse_delta(c.point, false, lt, loc, li, LOCAL_PATCH_RINGS, d)) {
+                d = cdt.obtuse_delta_of_insertion(c.point, false, loc, LOCAL_PATCH_RINGS);
+            }
+
+            set_delta(c, d);
+        }
+
+        return c.delta;
+    }
+
+    // Forget the candidates of faces that no longer exist
+    void prune() {
+        CDT& cdt = *(graph.cdt);
+
+        for (auto it = candidates.begin(); it != candidates.end();) {
+            const Face_vertices& v = it->second.face;
+
+            if (cdt.is_face(v[0], v[1], v[2])) {
+                ++it;
+            } else {
+                it = candidates.erase(it);
+            }
+        }
+    }
+
+private:
+    typedef std::array<const void*, 4> Key; // sorted vertices, strategy
+
+    struct Key_hash {
+        std::size_t operator()(const Key& k) const {
+            std::hash<const void*> h;
+            return ((h(k[0]) * 31 + h(k[1])) * 31 + h(k[2])) * 31 + h(k[3]);
+        }
+    };
+
+    void store(Candidate& entry, const Face_vertices& v, steiner_stategies::SteinerPoint& s) {
+        entry.face = v;
+
+        if (s) {
+            entry.generated = true;
+            entry.inside = boundary.bounded_side(*s) == CGAL::ON_BOUNDED_SIDE;
+            entry.point = std::move(*s.point);
+        }
+    }
+
+    static Key key(const Face_vertices& v, steiner_stategies::Strategy strategy) {
+        Key k = {&*v[0], &*v[1], &*v[2], reinterpret_cast<const void*>(static_cast<std::size_t>(strategy))};
+        std::sort(k.begin(), k.begin() + 3);
+        return k;
+    }
+
+    Graph& graph;
+    Polygon& boundary;
+    std::unordered_map<Key, Candidate, Key_hash> candidates;
+};
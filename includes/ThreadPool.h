@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Profiler.h"
+
+//
+// Fixed set of worker threads that run the iterations of a loop. run() hands
+// out the indices 0..n-1 and returns once all of them are done; the calling
+// thread takes part, so a pool of size 1 simply runs the loop. Each iteration
+// writes its own result slot, so the outcome does not depend on which thread
+// ran it. The workers count their events and CPU time for the profiler
+// context of the caller of run().
+//
+class ThreadPool {
+public:
+    ThreadPool(int threads) {
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wake.notify_all();
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int size() const {
+        return (int)workers.size() + 1;
+    }
+
+    void run(int n, const std::function<void(int)>& iteration) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job = &iteration;
+            context = profiler::currentContext();
+            jobs = n;
+            next = 0;
+            busy = (int)workers.size();
+            generation++;
+        }
+
+        wake.notify_all();
+
+        drain();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int)>* job = nullptr;
+    profiler::Context* context = nullptr;
+    int jobs = 0;
+    std::atomic<int> next{0};
+    int busy = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+
+    void drain() {
+        for (int i = next++; i < jobs; i = next++) {
+            (*job)(i);
+        }
+    }
+
+    void work() {
+        unsigned long seen = 0;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+
+                if (stopping) {
+                    return;
+                }
+
+                seen = generation;
+            }
+
+            {
+                profiler::TaskScope task(context);
+                drain();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if (--busy == 0) {
+                done.notify_one();
+            }
+        }
+    }
+};
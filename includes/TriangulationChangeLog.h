@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+//
+// Records the faces CGAL touches (and the vertices it creates) while the CDT
+// wrapper runs one of its modifying operations (insert, insert_no_flip,
+// insert_constraint).
+//
+// The custom face and vertex bases report every creation, change and
+// destruction to the log that is active on the current thread. Each face is
+// snapshotted once, on its first change, so after the operation the wrapper
+// knows exactly which faces disappeared (old state) and which ones exist now
+// (new state).
+//
+// While a transaction is open the log also keeps a journal: the complete
+// state (vertices, neighbors, constraint flags) of every face and vertex as it
+// was when the transaction began, plus the faces and vertices created since.
+// That is all the wrapper needs to undo the transaction in O(changed faces).
+//
+template <class Tds>
+class TriangulationChangeLog {
+public:
+    typedef typename Tds::Face Face;
+    typedef typename Tds::Vertex Vertex;
+    typedef typename Tds::Face_handle Face_handle;
+    typedef typename Tds::Vertex_handle Vertex_handle;
+    typedef typename Vertex::Point Point;
+
+    struct FaceRecord {
+        Face* face;                // current face, nullptr once destroyed
+        bool created;              // no state before the operation
+        Vertex_handle vertices[3]; // vertices before the first change
+        int obtuse;                // cached obtuse flag of the old state (-1: unknown)
+    };
+
+    struct FaceState {
+        Face* face;     // address of the face (key only once destroyed)
+        bool created;   // created during the transaction
+        bool alive;     // still part of the triangulation
+        Vertex_handle vertices[3];
+        Face_handle neighbors[3];
+        bool constrained[3];
+        int obtuse;
+        Face_handle handle; // filled in by the rollback
+    };
+
+    struct VertexState {
+        Vertex* vertex;
+        bool created;
+        bool alive;
+        Face_handle face;
+        Point point;
+        int id;
+        Vertex_handle handle; // filled in by the rollback
+    };
+
+    // Current operation
+    std::vector<FaceRecord> faces;
+    std::vector<Vertex*> vertices; // created
+    bool vertices_destroyed = false;
+
+    // Current transaction
+    std::vector<FaceState> journal_faces;
+    std::vector<VertexState> journal_vertices;
+
+    // Log that receives the notifications of the current thread
+    static TriangulationChangeLog*& active() {
+        static thread_local TriangulationChangeLog* log = nullptr;
+        return log;
+    }
+
+    void begin() {
+        faces.clear();
+        vertices.clear();
+        vertices_destroyed = false;
+        epoch = next_epoch();
+    }
+
+    void begin_journal() {
+        journal_faces.clear();
+        journal_vertices.clear();
+        journal_epoch = next_epoch();
+        journaling = true;
+    }
+
+    void end_journal() {
+        journaling = false;
+    }
+
+    bool is_journaling() const {
+        return journaling;
+    }
+
+    //
+    // Faces
+    //
+
+    void face_created(Face* f) {
+        f->change_epoch = epoch;
+        f->change_slot = (int)faces.size();
+
+        FaceRecord r;
+        r.face = f;
+        r.created = true;
+        r.obtuse = -1;
+        faces.push_back(r);
+
+        if (journaling) {
+            f->journal_epoch = journal_epoch;
+            f->journal_slot = (int)journal_faces.size();
+
+            FaceState s;
+            s.face = f;
+            s.created = true;
+            s.alive = true;
+            s.obtuse = -1;
+            journal_faces.push_back(s);
+        }
+    }
+
+    void face_changed(Face* f) {
+        if (journaling && f->journal_epoch != journal_epoch) {
+            f->journal_epoch = journal_epoch;
+            f->journal_slot = (int)journal_faces.size();
+
+            FaceState s;
+            s.face = f;
+            s.created = false;
+            s.alive = true;
+            s.obtuse = f->obtuse_flag();
+
+            for (int i = 0; i < 3; i++) {
+                s.vertices[i] = f->vertex(i);
+                s.neighbors[i] = f->neighbor(i);
+                s.constrained[i] = f->is_constrained(i);
+            }
+
+            journal_faces.push_back(s);
+        }
+
+        if (f->change_epoch == epoch) {
+            return; // already recorded
+        }
+
+        f->change_epoch = epoch;
+        f->change_slot = (int)faces.size();
+
+        FaceRecord r;
+        r.face = f;
+        r.created = false;
+        r.obtuse = f->obtuse_flag();
+
+        for (int i = 0; i < 3; i++) {
+            r.vertices[i] = f->vertex(i);
+        }
+
+        faces.push_back(r);
+    }
+
+    void face_destroyed(Face* f) {
+        face_changed(f);
+        faces[f->change_slot].face = nullptr;
+
+        if (journaling) {
+            journal_faces[f->journal_slot].alive = false;
+        }
+    }
+
+    //
+    // Vertices
+    //
+
+    void vertex_created(Vertex* v) {
+        vertices.push_back(v);
+
+        if (journaling) {
+            v->journal_epoch = journal_epoch;
+            v->journal_slot = (int)journal_vertices.size();
+
+            VertexState s;
+            s.vertex = v;
+            s.created = true;
+            s.alive = true;
+            journal_vertices.push_back(s);
+        }
+    }
+
+    void vertex_changed(Vertex* v) {
+        if (journaling && v->journal_epoch != journal_epoch) {
+            v->journal_epoch = journal_epoch;
+            v->journal_slot = (int)journal_vertices.size();
+
+            VertexState s;
+            s.vertex = v;
+            s.created = false;
+            s.alive = true;
+            s.face = v->face();
+            s.point = v->point();
+            s.id = v->id();
+            journal_vertices.push_back(s);
+        }
+    }
+
+    void vertex_destroyed(Vertex* v) {
+        vertex_changed(v);
+        vertices.erase(std::remove(vertices.begin(), vertices.end(), v), vertices.end());
+        vertices_destroyed = true;
+
+        if (journaling) {
+            journal_vertices[v->journal_slot].alive = false;
+        }
+    }
+
+private:
+    unsigned long epoch = 0;
+    unsigned long journal_epoch = 0;
+    bool journaling = false;
+
+    // Epochs are unique across threads, so a stale stamp left on a face by
+    // another operation can never match the running one
+    static unsigned long next_epoch() {
+        static std::atomic<unsigned long> counter(0);
+        return ++counter;
+    }
+};
@@ -9,12 +9,35 @@
 #include <CGAL/Lazy_exact_nt.h>
 #include <CGAL/squared_distance_2.h>
 #include <CGAL/convex_hull_2.h>
+#include <CGAL/Triangulation_data_structure_2.h>
+#include <CGAL/Triangulation_vertex_base_2.h>
+
+#if defined(POLYG_EXACT_GMPQ) || defined(POLYG_EXACT_CPP_RATIONAL)
+#include <CGAL/Gmpq.h>
+#include <CGAL/Lazy_kernel.h>
+#include <CGAL/Simple_cartesian.h>
+#endif
+
+#if defined(POLYG_EXACT_CPP_RATIONAL)
+#include <boost/multiprecision/cpp_int.hpp>
+#endif
 
 #include "CustomConstrainedDelaunayTriangulation_2.h"
+#include "CustomConstrainedTriangulationFaceBase_2.h"
+#include "CustomTriangulationVertexBase_2.h"
 
 #define BOOST_BIND_GLOBAL_PLACEHOLDERS
 
+// Kernel of the build: lazy exact constructions over the exact number type
+// chosen by POLYG_EXACT_NT (CMakeLists.txt)
+#if defined(POLYG_EXACT_GMPQ)
+typedef CGAL::Lazy_kernel<CGAL::Simple_cartesian<CGAL::Gmpq>> K;
+#elif defined(POLYG_EXACT_CPP_RATIONAL)
+typedef CGAL::Lazy_kernel<CGAL::Simple_cartesian<boost::multiprecision::cpp_rational>> K;
+#else
 typedef CGAL::Exact_predicates_exact_constructions_kernel K;
+#endif
+
 typedef CGAL::Delaunay_triangulation_2<K> Delaunay;
 typedef K::Point_2 Point;
 typedef CGAL::Polygon_2<K> Polygon_2;
@@ -22,7 +45,31 @@ typedef CGAL::Polygon_2<K> Polygon;
 typedef K::Line_2 Line;
 
 typedef CGAL::Exact_predicates_tag Itag;
-typedef CustomConstrainedDelaunayTriangulation_2<K, CGAL::Default, Itag> CDT;
+
+//
+// Compile-time policy of the search engines: the kernel, its number types
+// and the triangulation built on it
+//
+template <class Kernel_>
+struct TriangulationTraits {
+    typedef Kernel_ Kernel;
+    typedef typename Kernel::FT FT;
+    typedef typename FT::ET Exact_FT;
+    typedef typename Kernel::Point_2 Point;
+    typedef CGAL::Polygon_2<Kernel> Polygon;
+
+    typedef CustomTriangulationVertexBase_2<Kernel> Vb;
+    typedef CustomConstrainedTriangulationFaceBase_2<Kernel> Fb;
+    typedef CGAL::Triangulation_data_structure_2<Vb, Fb> Tds;
+    typedef CustomConstrainedDelaunayTriangulation_2<Kernel, Tds, Itag> CDT;
+};
+
+typedef TriangulationTraits<K> SearchTraits;
+
+typedef SearchTraits::Vb Vb;
+typedef SearchTraits::Fb Fb;
+typedef SearchTraits::Tds Tds;
+typedef SearchTraits::CDT CDT;
 typedef CDT::Point Point;
 typedef CDT::Edge Edge;
 typedef CDT::Face Face;
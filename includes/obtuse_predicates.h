@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include <CGAL/Interval_nt.h>
+#include <CGAL/Kernel/global_functions.h>
+#include <CGAL/enum.h>
+
+#include "Profiler.h"
+
+//
+// Staged test of the angles of a triangle, same answers as CGAL::angle:
+//  1. input points (integer coordinates): exact dot products in 128 bits,
+//  2. coordinates that are doubles: dot products with a certified error bound,
+//  3. other points: interval arithmetic on the approximations of the kernel,
+//  4. exact kernel, only for the angles the filters could not decide.
+//
+namespace obtuse_predicates {
+
+// Integer coordinates up to 2^52: differences fit 54 bits, dot products 109
+const double INTEGER_LIMIT = 4503599627370496.0;
+
+// Relative error of a dot product of differences (4u) doubled, u = 2^-53
+const double DOT_ERROR = 8.0 / 9007199254740992.0;
+
+// Below this the error bound could be spoiled by underflow
+const double DOT_MIN = 1e-280;
+
+inline bool is_integer(double v) {
+    return std::fabs(v) <= INTEGER_LIMIT && std::floor(v) == v;
+}
+
+// Sign of (p - q).(r - q) in exact 128-bit arithmetic
+inline int integer_dot_sign(const double x[3], const double y[3], int p, int q, int r) {
+    __int128 dx1 = (int64_t)x[p] - (int64_t)x[q];
+    __int128 dy1 = (int64_t)y[p] - (int64_t)y[q];
+    __int128 dx2 = (int64_t)x[r] - (int64_t)x[q];
+    __int128 dy2 = (int64_t)y[r] - (int64_t)y[q];
+
+    __int128 dot = dx1 * dx2 + dy1 * dy2;
+
+    return dot < 0 ? -1 : (dot > 0 ? 1 : 0);
+}
+
+// Sign of (p - q).(r - q) in doubles, 2 when the error bound cannot decide
+inline int double_dot_sign(const double x[3], const double y[3], int p, int q, int r) {
+    double dx1 = x[p] - x[q], dy1 = y[p] - y[q];
+    double dx2 = x[r] - x[q], dy2 = y[r] - y[q];
+
+    double dot = dx1 * dx2 + dy1 * dy2;
+    double magnitude = std::fabs(dx1 * dx2) + std::fabs(dy1 * dy2);
+
+    if (!std::isfinite(magnitude) || magnitude < DOT_MIN) {
+        return 2;
+    }
+
+    double error = magnitude * DOT_ERROR;
+
+    if (dot > error) {
+        return 1;
+    }
+
+    if (dot < -error) {
+        return -1;
+    }
+
+    return 2;
+}
+
+// Sign of (p - q).(r - q) on intervals, 2 when the intervals overlap zero
+template <class Interval_point>
+int interval_dot_sign(const Interval_point* approx[3], int p, int q, int r) {
+    typename CGAL::Interval_nt<false>::Protector protection;
+
+    auto dot = (approx[p]->x() - approx[q]->x()) * (approx[r]->x() - approx[q]->x()) + (approx[p]->y() - approx[q]->y()) * (approx[r]->y() - approx[q]->y());
+
+    if (dot.inf() > 0) {
+        return 1;
+    }
+
+    if (dot.sup() < 0) {
+        return -1;
+    }
+
+    if (dot.is_point()) {
+        return 0;
+    }
+
+    return 2;
+}
+
+// Index (0, 1, 2) of the obtuse angle of the triangle abc, -1 if there is none
+template <class Point_2>
+int obtuse_vertex(const Point_2& a, const Point_2& b, const Point_2& c) {
+    typedef typename std::remove_reference<decltype(a.approx())>::type Approx_point;
+
+    const Point_2* points[3] = {&a, &b, &c};
+    Approx_point* approx[3] = {&a.approx(), &b.approx(), &c.approx()};
+
+    double x[3], y[3];
+    bool doubles = true, integers = true;
+
+    for (int i = 0; i < 3 && doubles; i++) {
+        doubles = approx[i]->x().is_point() && approx[i]->y().is_point();
+        x[i] = approx[i]->x().inf();
+        y[i] = approx[i]->y().inf();
+        integers = integers && is_integer(x[i]) && is_integer(y[i]);
+    }
+
+    POLYG_COUNT(OBTUSE_TESTS);
+
+    if (doubles && integers) {
+        POLYG_COUNT(OBTUSE_INTEGER);
+    } else if (doubles) {
+        POLYG_COUNT(OBTUSE_DOUBLE);
+    } else {
+        POLYG_COUNT(OBTUSE_INTERVAL);
+    }
+
+    // Angle at the middle vertex of each triple: b, a, c (as CGAL::angle is called)
+    const int order[3][3] = {{0, 1, 2}, {1, 0, 2}, {0, 2, 1}};
+
+    for (const auto& o : order) {
+        int sign;
+
+        if (doubles && integers) {
+            sign = integer_dot_sign(x, y, o[0], o[1], o[2]);
+        } else if (doubles) {
+            sign = double_dot_sign(x, y, o[0], o[1], o[2]);
+        } else {
+            sign = interval_dot_sign(approx, o[0], o[1], o[2]);
+        }
+
+        if (sign == 2) {
+            POLYG_COUNT(OBTUSE_EXACT);
+            sign = CGAL::angle(*points[o[0]], *points[o[1]], *points[o[2]]) == CGAL::OBTUSE ? -1 : 1;
+        }
+
+        if (sign < 0) {
+            return o[1];
+        }
+    }
+
+    return -1;
+}
+
+} // namespace obtuse_predicates
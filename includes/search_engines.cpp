@@ -0,0 +1,7 @@
+#include "search_engines.h"
+
+// Explicit instantiations for the kernel selected by POLYG_EXACT_NT
+template class SimpleTriangulationSearch<SearchTraits>;
+template class LocalSearch<SearchTraits>;
+template class SimulatedAnnealingSearch<SearchTraits>;
+template class AntColonySearch<SearchTraits>;
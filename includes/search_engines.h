@@ -0,0 +1,16 @@
+#pragma once
+
+// Search engines
+#include "SimpleTriangulationSearch.h"
+#include "LocalSearch.h"
+#include "SimulatedAnnealingSearch.h"
+#include "AntColonySearch.h"
+
+//
+// The engines are instantiated once, for the traits of this build, in
+// search_engines.cpp
+//
+extern template class SimpleTriangulationSearch<SearchTraits>;
+extern template class LocalSearch<SearchTraits>;
+extern template class SimulatedAnnealingSearch<SearchTraits>;
+extern template class AntColonySearch<SearchTraits>;
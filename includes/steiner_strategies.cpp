@@ -2,6 +2,8 @@
 #include <cmath>
 #include <vector>
 
+#include "Log.h"
+#include "Profiler.h"
 #include "cgal_definitions.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
@@ -9,7 +11,7 @@
 
 using namespace std;
 
-Point * steiner_stategies::generateSteinerPointFromMaxEdge(Graph & graph, Point& a, Point& b, Point& c) {
+std::optional<Point> steiner_stategies::generateSteinerPointFromMaxEdge(Graph & graph, Point& a, Point& b, Point& c) {
     K::FT length12_sq = CGAL::squared_distance(a, b);
 
     K::FT length23_sq = CGAL::squared_distance(b, c);
@@ -17,23 +19,19 @@ Point * steiner_stategies::generateSteinerPointFromMaxEdge(Graph & graph, Point&
     K::FT length31_sq = CGAL::squared_distance(c, a);
 
     if (length12_sq >= length23_sq && length12_sq >= length31_sq) {
-        return new Point((a.x() + b.x()) / 2, (a.y() + b.y()) / 2);
+        return Point((a.x() + b.x()) / 2, (a.y() + b.y()) / 2);
     } else if (length23_sq >= length12_sq && length23_sq >= length31_sq) {
-        return new Point((b.x() + c.x()) / 2, (b.y() + c.y()) / 2);
+        return Point((b.x() + c.x()) / 2, (b.y() + c.y()) / 2);
     } else {
-        return new Point((c.x() + a.x()) / 2, (c.y() + a.y()) / 2);
+        return Point((c.x() + a.x()) / 2, (c.y() + a.y()) / 2);
     }
 }
 
-Point * steiner_stategies::generateSteinerPointFromPericenter(Graph & graph, Point& a, Point& b, Point& c) {
-    Point circumcenter = CGAL::circumcenter(a, b, c);
-
-    Point * p = new Point(circumcenter);
-
-    return p;
+std::optional<Point> steiner_stategies::generateSteinerPointFromPericenter(Graph & graph, Point& a, Point& b, Point& c) {
+    return CGAL::circumcenter(a, b, c);
 }
 
-Point * steiner_stategies::generateSteinerPointInsideConvexHull(Graph & graph, Point& a, Point& b, Point& c) {
+std::optional<Point> steiner_stategies::generateSteinerPointInsideConvexHull(Graph & graph, Point& a, Point& b, Point& c) {
     CDT & cdt = *(graph.cdt);
 
     // cout << "Examining triangle " << a << " " << b << " " << c << endl;
@@ -110,85 +108,164 @@ Point * steiner_stategies::generateSteinerPointInsideConvexHull(Graph & graph, P
 
 
         Point centroid = utils::centroid(boundary);
-        return new Point(centroid);
+        return centroid;
     } else {
-        return nullptr;
+        return std::nullopt;
     }
 }
 
-Point * steiner_stategies::generateSteinerPointProjection(Graph & graph, Point& a, Point& b, Point& c) {
+std::optional<Point> steiner_stategies::generateSteinerPointProjection(Graph & graph, Point& a, Point& b, Point& c) {
     int i = utils::find_obtuse_angle(a,b,c);
 
     if (i == 0) { // A
         Line templine(b, c);
         Point projection = templine.projection(a);
-        return new Point(projection);
+        return projection;
     } else if (i == 1) { // B
         Line templine(a, c);
         Point projection = templine.projection(b);
-        return new Point(projection); 
+        return projection;
     } else if (i == 2) { // C
          Line templine(a, b);
         Point projection = templine.projection(c);
-        return new Point(projection);
+        return projection;
     }
      
-    return nullptr;
+    return std::nullopt;
 }
 
-Point * steiner_stategies::generateSteinerPointBiSector(Graph & graph, Point& a, Point& b, Point& c) {
+std::optional<Point> steiner_stategies::generateSteinerPointBiSector(Graph & graph, Point& a, Point& b, Point& c) {
     // TODO
-    return nullptr;
+    return std::nullopt;
 }
 
 
-Point * steiner_stategies::generateSteinerPointAltitude(Graph & graph, Point & a, Point & b, Point &c) {
+std::optional<Point> steiner_stategies::generateSteinerPointAltitude(Graph & graph, Point & a, Point & b, Point &c) {
     // TODO
-    return nullptr;
+    return std::nullopt;
 }
 
-Point * steiner_stategies::generateSteinerPoint(Graph & graph, Point& a, Point& b, Point& c, Strategy strategy) {
+steiner_stategies::SteinerPoint steiner_stategies::generateSteinerPoint(Graph & graph, Point& a, Point& b, Point& c, Strategy strategy) {
+    profiler::PrimitiveScope scope(profiler::STRATEGY_GENERATION);
+
+    SteinerPoint result;
+
+    result.strategy = strategy;
+    result.face = {a, b, c};
+
     if (strategy == MAX_EDGE) {
-        return generateSteinerPointFromMaxEdge(graph, a, b, c);
-    }
+        result.point = generateSteinerPointFromMaxEdge(graph, a, b, c);
+    } else if (strategy == PERICENTER) {
+        result.point = generateSteinerPointFromPericenter(graph, a, b, c);
+    } else if (strategy == POLYGON) {
+        result.point = generateSteinerPointInsideConvexHull(graph, a, b, c);
+        result.mutated_graph = result.point.has_value(); // the hull was added as constraints
+    } else if (strategy == BISECTION) {
+        result.point = generateSteinerPointBiSector(graph, a, b, c);
+    } else if (strategy == ALTITUDE) {
+        result.point = generateSteinerPointAltitude(graph, a, b, c);
+    } else {
+        if (strategy != PROJECTION) {
+            POLYG_LOG(WARN, "Warning: strategy not defined - using as default projectin method");
+        }
 
-    if (strategy == PERICENTER) {
-        return generateSteinerPointFromPericenter(graph, a, b, c);
+        result.point = generateSteinerPointProjection(graph, a, b, c);
     }
 
-    if (strategy == POLYGON) {
-        return generateSteinerPointInsideConvexHull(graph, a, b, c);
-    }
+    return result;
+}
 
-    if (strategy == BISECTION) {
-        return generateSteinerPointBiSector(graph, a, b, c);
-    }
+steiner_stategies::TriangleGeometry steiner_stategies::triangleGeometry(const Point& a, const Point& b, const Point& c) {
+    profiler::PrimitiveScope scope(profiler::STRATEGY_GENERATION);
+
+    TriangleGeometry g;
 
-    if (strategy == ALTITUDE) {
-        return generateSteinerPointAltitude(graph, a, b, c);
+    g.vertices = {a, b, c};
+    g.squared_lengths = {CGAL::squared_distance(b, c), CGAL::squared_distance(c, a), CGAL::squared_distance(a, b)};
+
+    // Same choice as generateSteinerPointFromMaxEdge
+    const K::FT& ab = g.squared_lengths[2];
+    const K::FT& bc = g.squared_lengths[0];
+    const K::FT& ca = g.squared_lengths[1];
+
+    if (ab >= bc && ab >= ca) {
+        g.longest = 2;
+    } else if (bc >= ab && bc >= ca) {
+        g.longest = 0;
+    } else {
+        g.longest = 1;
     }
 
-    if (strategy != PROJECTION) {
-        cerr << "Warning: strategy not defined - using as default projectin method" << endl;
+    g.obtuse = utils::find_obtuse_angle(g.vertices[0], g.vertices[1], g.vertices[2]);
+    g.circumcenter = CGAL::circumcenter(a, b, c);
+
+    if (g.obtuse >= 0) {
+        Line opposite(g.vertices[(g.obtuse + 1) % 3], g.vertices[(g.obtuse + 2) % 3]);
+        g.projection = opposite.projection(g.vertices[g.obtuse]);
     }
 
-    return generateSteinerPointProjection(graph, a, b, c);
+    g.radius_to_height_ratio = utils::radius_to_height_ratio(CGAL::to_double(bc), CGAL::to_double(ca), CGAL::to_double(ab));
+
+    return g;
 }
 
-void steiner_stategies::printStrategy(Strategy strategy) {
+steiner_stategies::SteinerPoint steiner_stategies::generateSteinerPoint(Graph& graph, const TriangleGeometry& geometry, Strategy strategy) {
+    if (strategy != MAX_EDGE && strategy != PERICENTER && strategy != PROJECTION) {
+        std::array<Point, 3> v = geometry.vertices;
+        return generateSteinerPoint(graph, v[0], v[1], v[2], strategy);
+    }
+
+    profiler::PrimitiveScope scope(profiler::STRATEGY_GENERATION);
+    SteinerPoint result;
+
+    result.strategy = strategy;
+    result.face = geometry.vertices;
+
     if (strategy == MAX_EDGE) {
-        cout << "MAX_EDGE  ";
+        const Point& p = geometry.vertices[(geometry.longest + 1) % 3];
+        const Point& q = geometry.vertices[(geometry.longest + 2) % 3];
+        result.point = CGAL::midpoint(p, q);
     } else if (strategy == PERICENTER) {
-        cout << "PERICENTER";
-    } else if (strategy == POLYGON) {
-        cout << "POLYGON   ";
-    } else if (strategy == BISECTION) {
-        cout << "BISECTION ";
-    } else if (strategy == ALTITUDE) {
-        cout << "ALTITUDE  ";
-    } else if (strategy == PROJECTION) {
-        cout << "PROJECTION";
+        result.point = geometry.circumcenter;
     } else {
-        cout << "UNKNOWN STRATEGY";
+        result.point = geometry.projection;
     }
-}
\ No newline at end of file
+
+    return result;
+}
+
+std::vector<steiner_stategies::SteinerPoint> steiner_stategies::generateSteinerPoints(Graph& graph, const TriangleGeometry& geometry, const std::vector<Strategy>& strategies) {
+    std::vector<SteinerPoint> results;
+
+    results.reserve(strategies.size());
+
+    for (Strategy strategy : strategies) {
+        results.push_back(generateSteinerPoint(graph, geometry, strategy));
+    }
+
+    return results;
+}
+
+const char* steiner_stategies::strategyLabel(Strategy strategy) {
+    switch (strategy) {
+    case MAX_EDGE: return "MAX_EDGE  ";
+    case PERICENTER: return "PERICENTER";
+    case POLYGON: return "POLYGON   ";
+    case BISECTION: return "BISECTION ";
+    case ALTITUDE: return "ALTITUDE  ";
+    case PROJECTION: return "PROJECTION";
+    default: return "UNKNOWN STRATEGY";
+    }
+}
+
+const char* steiner_stategies::strategyName(Strategy strategy) {
+    switch (strategy) {
+    case MAX_EDGE: return "MAX_EDGE";
+    case PERICENTER: return "PERICENTER";
+    case POLYGON: return "POLYGON";
+    case PROJECTION: return "PROJECTION";
+    case BISECTION: return "BISECTION";
+    case ALTITUDE: return "ALTITUDE";
+    default: return "NONE";
+    }
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <optional>
+#include <vector>
+
 #include "cgal_definitions.h"
 #include "graph_definitions.h"
 
@@ -16,20 +20,63 @@ namespace steiner_stategies {
         NONE,
     };
 
-    void printStrategy(Strategy strategy);
+    // Result of a strategy for the face abc
+    struct SteinerPoint {
+        Strategy strategy = NONE;
+        std::array<Point, 3> face;  // vertices of the source face
+        std::optional<Point> point; // empty when the strategy has no point for the face
+        bool mutated_graph = false; // constraints were added to the triangulation (POLYGON)
+
+        explicit operator bool() const {
+            return point.has_value();
+        }
+
+        const Point& operator*() const {
+            return *point;
+        }
+
+        const Point* operator->() const {
+            return &*point;
+        }
+    };
+
+    // Geometry of a triangle abc shared by the strategies; index i is the
+    // vertex i and the edge opposite to it
+    struct TriangleGeometry {
+        std::array<Point, 3> vertices;
+        std::array<K::FT, 3> squared_lengths;
+        int longest = 0;                   // opposite to the longest edge (ties: ab, bc, ca)
+        int obtuse = -1;                   // obtuse vertex, -1 if there is none
+        Point circumcenter;
+        std::optional<Point> projection;   // foot of the altitude from the obtuse vertex
+        float radius_to_height_ratio = -1; // -1 if degenerate
+    };
+
+    TriangleGeometry triangleGeometry(const Point & a, const Point & b, const Point & c);
+
+    // Point of the strategy from the shared geometry (other strategies fall back to the vertices)
+    SteinerPoint generateSteinerPoint(Graph & graph, const TriangleGeometry & geometry, Strategy strategy);
+
+    // Points of all the strategies for the triangle, in the order of strategies
+    std::vector<SteinerPoint> generateSteinerPoints(Graph & graph, const TriangleGeometry & geometry, const std::vector<Strategy> & strategies);
+
+    // Name padded to the width of the log columns
+    const char* strategyLabel(Strategy strategy);
+
+    const char* strategyName(Strategy strategy);
 
-    Point * generateSteinerPointFromMaxEdge(Graph & graph, Point & a, Point & b, Point &c);
+    std::optional<Point> generateSteinerPointFromMaxEdge(Graph & graph, Point & a, Point & b, Point &c);
 
-    Point * generateSteinerPointFromPericenter(Graph & graph, Point & a, Point & b, Point &c);
+    std::optional<Point> generateSteinerPointFromPericenter(Graph & graph, Point & a, Point & b, Point &c);
 
-    Point * generateSteinerPointInsideConvexHull(Graph & graph, Point & a, Point & b, Point &c);
+    std::optional<Point> generateSteinerPointInsideConvexHull(Graph & graph, Point & a, Point & b, Point &c);
 
-    Point * generateSteinerPointProjection(Graph & graph, Point & a, Point & b, Point &c);
+    std::optional<Point> generateSteinerPointProjection(Graph & graph, Point & a, Point & b, Point &c);
 
-    Point * generateSteinerPoint(Graph & graph, Point & a, Point & b, Point &c, Strategy strategy);
+    SteinerPoint generateSteinerPoint(Graph & graph, Point & a, Point & b, Point &c, Strategy strategy);
 
 
-    Point * generateSteinerPointBiSector(Graph & graph, Point & a, Point & b, Point &c);
+    std::optional<Point> generateSteinerPointBiSector(Graph & graph, Point & a, Point & b, Point &c);
 
-    Point * generateSteinerPointAltitude(Graph & graph, Point & a, Point & b, Point &c);
+    std::optional<Point> generateSteinerPointAltitude(Graph & graph, Point & a, Point & b, Point &c);
 }
\ No newline at end of file
@@ -1,3 +1,12 @@
 #pragma once
 
-// #define MAX_ITERATIONS 10
\ No newline at end of file
+// #define MAX_ITERATIONS 10
+
+// Size (in rings of faces) of the local patch used to evaluate trial insertions
+#define LOCAL_PATCH_RINGS 2
+
+// Obtuse faces whose trials are evaluated together by the threads (LocalSearch)
+#define PARALLEL_BATCH_FACES 64
+
+// Steiner coordinates formatted per task when the solution is written (JsonExporter)
+#define EXPORT_CHUNK_POINTS 1024
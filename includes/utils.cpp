@@ -1,8 +1,18 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <gmp.h>
+#include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include <CGAL/Fraction_traits.h>
+
+#include "Log.h"
+#include "Profiler.h"
 #include "cgal_definitions.h"
+#include "obtuse_predicates.h"
 #include "utils.hpp"
 
 using namespace std;
@@ -47,56 +57,55 @@ namespace utils
 }
 
 bool utils::is_obtuse(Point& a, Point& b, Point& c) {
-    if (CGAL::angle(a, b, c) == CGAL::OBTUSE) {
-        return true;
-    }
-
-    if (CGAL::angle(b, a, c) == CGAL::OBTUSE) {
-        return true;
-    }
+    return obtuse_predicates::obtuse_vertex(a, b, c) >= 0;
+}
 
-    if (CGAL::angle(a, c, b) == CGAL::OBTUSE) {
-        return true;
-    }
+int utils::find_obtuse_angle(Point& a, Point& b, Point& c) {
+    // 0:a, 1:b, 2:c, -1 when the triangle is not obtuse
+    return obtuse_predicates::obtuse_vertex(a, b, c);
+}
 
-    return false;
+float utils::radius_to_height_ratio(const Point& p1, const Point& p2, const Point& p3) {
+    return radius_to_height_ratio(CGAL::to_double(CGAL::squared_distance(p2, p3)), CGAL::to_double(CGAL::squared_distance(p1, p3)),
+                                  CGAL::to_double(CGAL::squared_distance(p1, p2)));
 }
 
-int utils::find_obtuse_angle(Point& a, Point& b, Point& c) {
-    if (CGAL::angle(a, b, c) == CGAL::OBTUSE) {
-        return 1;
-    }
+float utils::radius_to_height_ratio(double squared_a, double squared_b, double squared_c) {
+    // Calculate side lengths of the triangle
+    float a = std::sqrt(squared_a);
+    float b = std::sqrt(squared_b);
+    float c = std::sqrt(squared_c);
 
-    if (CGAL::angle(b, a, c) == CGAL::OBTUSE) {
-        return 0;
-    }
+    // Calculate the semi-perimeter of the triangle
+    float s = (a + b + c) / 2.0f;
 
-    if (CGAL::angle(a, c, b) == CGAL::OBTUSE) {
-        return 2;
+    // Calculate the area of the triangle using Heron's formula
+    float area = std::sqrt(s * (s - a) * (s - b) * (s - c));
+
+    // Check if the area is zero to prevent division by zero
+    if (area == 0) {
+        POLYG_LOG(WARN, "Degenerate triangle detected!");
+        return -1.0f; // Indicate an error
     }
 
-    return -1;
-}
+    // Calculate the circumradius R
+    float R = (a * b * c) / (4.0f * area);
 
-bool utils::checkConstraints(const CDT& cdt, const Point& p1, const Point& p2) {
-    CDT::Segment seg(p1, p2);
+    // Find the longest side
+    float longest_side = std::max({a, b, c});
 
-    for (auto edge = cdt.finite_edges_begin(); edge != cdt.finite_edges_end(); ++edge) {
-        CDT::Edge edge_info = *edge;
+    // Calculate the height corresponding to the longest side
+    float height = (2.0f * area) / longest_side;
 
-        if (cdt.is_constrained(edge_info)) {
+    // Calculate the radius-to-height ratio
+    float rho = R / height;
 
-            auto segment = cdt.segment(edge);
+    return rho;
+}
 
-            if (segment.source() == p1 && segment.target() == p2) {
-                return true;
-            }
-            if (segment.source() == p2 && segment.target() == p1) {
-                return true;
-            }
-        }
-    }
-    return false; // The pair is not in the constraints
+bool utils::checkConstraints(CDT& cdt, const Point& p1, const Point& p2) {
+    // Hashed index maintained by the triangulation
+    return cdt.is_constrained_edge(p1, p2);
 }
 
 std::tuple<int, int> utils::findOppositeEdge(int vertexIndex) {
@@ -108,32 +117,68 @@ std::tuple<int, int> utils::findOppositeEdge(int vertexIndex) {
     case 2:                           // Vertex c
         return std::make_tuple(0, 1); // Edge ab
     default:
-        cout << "CRITICAL ERROR: Invalid vertex index. Must be 0, 1, or 2. \n";
+        POLYG_LOG(ERROR, "CRITICAL ERROR: Invalid vertex index. Must be 0, 1, or 2. ");
         exit(1);
     }
 }
 
-string utils::coordinate_to_rational(const K::FT& coord) {
-    const auto exact_coord = CGAL::exact(coord);
+namespace {
+
+// Decimal digits of a GMP integer, written straight into out
+void append_mpz(string& out, mpz_srcptr z) {
+    size_t at = out.size();
+
+    out.resize(at + mpz_sizeinbase(z, 10) + 2); // sign and terminator
+    mpz_get_str(&out[at], 10, z);
+    out.resize(at + strlen(&out[at]));
+}
+
+template <typename Integer>
+void append_integer(string& out, const Integer& z) {
+    thread_local std::ostringstream stream;
+
+    stream.str("");
+    stream << z;
+    out += stream.str();
+}
+
+#ifdef CGAL_USE_GMP
+void append_integer(string& out, const CGAL::Gmpz& z) {
+    append_mpz(out, z.mpz());
+}
+#endif
+
+#ifdef CGAL_USE_GMPXX
+void append_integer(string& out, const mpz_class& z) {
+    append_mpz(out, z.get_mpz_t());
+}
+#endif
 
-    cout << exact_coord << endl;
+} // namespace
 
-    const mpq_t* gmpq_ptr = reinterpret_cast<const mpq_t*>(&exact_coord);
+void utils::append_rational(string& out, const K::FT& coord) {
+    append_rational(out, CGAL::exact(coord));
+}
 
-    mpz_t num, den;
-    mpz_init(num);
-    mpz_init(den);
+void utils::append_rational(string& out, const K::FT::ET& coord) {
+    // Split through the traits of the exact type, whatever the kernel uses
+    // (Gmpq, mpq_class, boost rationals)
+    typedef CGAL::Fraction_traits<K::FT::ET> Traits;
 
-    mpq_get_num(num, *gmpq_ptr); // Get the numerator
-    mpq_get_den(den, *gmpq_ptr); // Get the denominator
+    Traits::Numerator_type num;
+    Traits::Denominator_type den;
 
-    char* num_str = mpz_get_str(nullptr, 10, num);
-    char* den_str = mpz_get_str(nullptr, 10, den);
+    Traits::Decompose()(coord, num, den);
 
-    std::string result = std::string(num_str) + "/" + std::string(den_str);
+    append_integer(out, num);
+    out += '/';
+    append_integer(out, den);
+}
 
-    mpz_clear(num);
-    mpz_clear(den);
+string utils::coordinate_to_rational(const K::FT& coord) {
+    string result;
+
+    append_rational(result, coord);
 
     return result;
 }
@@ -170,65 +215,38 @@ bool utils::isConvex(Polygon& polygon) {
     return true;
 }
 
-Face* utils::findNeighbor(Graph& graph, Point& a, Point& b, Point& c, int vertex_index, int & neighbor_vertex_index) {
-    CDT& cdt = *(graph.cdt);
-    bool no_neighbor_because_of_constraint = false;
-
-    if (vertex_index == 0) {
-        no_neighbor_because_of_constraint = checkConstraints(cdt, b, c);
-    }
-    if (vertex_index == 1) {
-        no_neighbor_because_of_constraint = checkConstraints(cdt, a, c);
-    }
-    if (vertex_index == 2) {
-        no_neighbor_because_of_constraint = checkConstraints(cdt, a, b);
-    }
-
-    if (no_neighbor_because_of_constraint) {
+Face* utils::findNeighbor(CDT& cdt, CDT::Face_handle face, int vertex_index, int& neighbor_vertex_index) {
+    if (cdt.is_constrained(CDT::Edge(face, vertex_index))) {
         return nullptr;
     }
 
-    Point x, y;
+    CDT::Face_handle neighbor = face->neighbor(vertex_index);
 
-    if (vertex_index == 0) {
-        x = b;
-        y = c;
-    }
-    if (vertex_index == 1) {
-        x = a;
-        y = c;
-    }
-    if (vertex_index == 2) {
-        x = a;
-        y = b;
+    if (cdt.is_infinite(neighbor)) {
+        return nullptr;
     }
 
-    for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-        Point aa = fit->vertex(0)->point();
-        Point bb = fit->vertex(1)->point();
-        Point cc = fit->vertex(2)->point();
+    neighbor_vertex_index = cdt.mirror_index(face, vertex_index);
 
-        if (aa == a && bb == b && cc == c) {
-            continue;
-        }
+    return &(*neighbor);
+}
 
-        if ((aa == x && bb == y) || (aa == y && bb == x)) {
-            neighbor_vertex_index = 2;
-            return &(*fit);
-        }
+Face* utils::findNeighbor(Graph& graph, Point& a, Point& b, Point& c, int vertex_index, int & neighbor_vertex_index) {
+    CDT& cdt = *(graph.cdt);
 
-        if ((bb == x && cc == y) || (bb == y && cc == x)) {
-            neighbor_vertex_index = 0;
-            return &(*fit);
-        }
+    Vertex_handle va = cdt.vertex_at(a);
+    Vertex_handle vb = cdt.vertex_at(b);
+    Vertex_handle vc = cdt.vertex_at(c);
+    CDT::Face_handle face;
 
-        if ((cc == x && aa == y) || (cc == y && aa == x)) {
-            neighbor_vertex_index = 1;
-            return &(*fit);            
-        }
+    if (va == Vertex_handle() || vb == Vertex_handle() || vc == Vertex_handle() || !cdt.is_face(va, vb, vc, face)) {
+        return nullptr;
     }
 
-    return nullptr;
+    // vertex_index refers to the order a, b, c, not to the order of the face
+    Vertex_handle v = vertex_index == 0 ? va : (vertex_index == 1 ? vb : vc);
+
+    return findNeighbor(cdt, face, face->index(v), neighbor_vertex_index);
 }
 
 Point utils::centroid(std::vector<Point>& points) {
@@ -277,17 +295,8 @@ bool utils::is_convex(const std::vector<Point>& boundary) {
 }
 
 int utils::countObtuseTriangles(CDT& cdt) {
-    int counter = 0;
-
-     for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-        Point a = fit->vertex(0)->point();
-        Point b = fit->vertex(1)->point();
-        Point c = fit->vertex(2)->point();
-
-        if (utils::is_obtuse(a, b, c)) {
-            counter++;
-        }
-    }
+    profiler::PrimitiveScope scope(profiler::COUNT_OBTUSE);
 
-    return counter;
+    // Maintained incrementally by the triangulation
+    return cdt.number_of_obtuse_faces();
 }
\ No newline at end of file
@@ -17,11 +17,21 @@ namespace utils {
 
     int find_obtuse_angle(Point & a, Point & b, Point &c);
 
-    string coordinate_to_rational(const K::FT& coord);    
+    // Circumradius over the height on the longest side (-1 if degenerate)
+    float radius_to_height_ratio(const Point& p1, const Point& p2, const Point& p3);
+
+    // Same from the squared side lengths
+    float radius_to_height_ratio(double squared_a, double squared_b, double squared_c);
+
+    string coordinate_to_rational(const K::FT& coord);
+
+    // Appends "numerator/denominator" of a coordinate to out (exact value)
+    void append_rational(string& out, const K::FT& coord);
+    void append_rational(string& out, const K::FT::ET& coord);
 
     std::tuple<int, int> findOppositeEdge(int vertexIndex);
 
-    bool checkConstraints(const CDT& cdt, const Point& p1, const Point& p2);
+    bool checkConstraints(CDT& cdt, const Point& p1, const Point& p2);
 
     Point findGeometricalMean(Polygon & polygon);
 
@@ -39,12 +49,15 @@ namespace utils {
     // index 2: vertex c: edge: ab
     Face * findNeighbor(Graph & graph, Point& a, Point& b, Point& c, int vertex_index, int & neighbor_vertex_index);
 
+    // Same through the adjacency of the face: vertex_index is an index of face,
+    // neighbor_vertex_index the index of the neighbor opposite to the shared edge
+    // (nullptr if that edge is constrained or on the convex hull)
+    Face * findNeighbor(CDT & cdt, CDT::Face_handle face, int vertex_index, int & neighbor_vertex_index);
+
 
     bool is_convex(const std::vector<Point>& boundary);
 
 
 }
 
-string to_rational(const K::FT& coord);
-
 #endif
@@ -1,8 +1,13 @@
 // Standard C++
-#include <gmp.h>
+#include <algorithm>
+#include <csignal>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <map>
-#include <time.h>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 // Macros and headers for CGAL
@@ -18,217 +23,222 @@
 #include "triangulation_configuration.h"
 
 // Support classes
-#include "JsonExporter.h"
-#include "JsonLoader.h"
+#include "Deadline.h"
+#include "Log.h"
+#include "Solver.h"
+#include "ThreadPool.h"
 #include "graph_definitions.h"
-#include "steiner_strategies.h"
 #include "utils.hpp"
 
-#include "SimpleTriangulationSearch.h"
-#include "LocalSearch.h"
-#include "SimulatedAnnealingSearch.h"
-#include "AntColonySearch.h"
-
 // Namespaces
 using namespace std;
 
-string to_rational(const K::FT& coord) {
-    const auto exact_coord = CGAL::exact(coord);
-
-    const mpq_t* gmpq_ptr = reinterpret_cast<const mpq_t*>(&exact_coord);
-
-    mpz_t num, den;
-    mpz_init(num);
-    mpz_init(den);
-
-    mpq_get_num(num, *gmpq_ptr); // Get the numerator
-    mpq_get_den(den, *gmpq_ptr); // Get the denominator
-
-    char* num_str = mpz_get_str(nullptr, 10, num);
-    char* den_str = mpz_get_str(nullptr, 10, den);
+// One instance, the triangulation shown at the end if draw
+int solve(const char* inputfile, const char* outputfile, SolveReport& report, bool draw) {
+    CDT cdt;
 
-    std::string result = std::string(num_str) + "/" + std::string(den_str);
+    int result = solve(inputfile, outputfile, report, cdt);
 
-    mpz_clear(num);
-    mpz_clear(den);
+    if (result == 0 && draw) {
+        logging::flush();
+        CGAL::draw(cdt);
+    }
 
     return result;
 }
 
-int main(int argc, char* argv[]) {
-    srand(time(0));
-
-    if (argc != 3) {
-        cout << "Invalid arguments: syntax: ./polyg input.json output.json" << endl;
-        return 0;
-    }
-
-    cout << "Checking CGAL version ... " << CGAL_VERSION_STR << endl;
-
-    const char* inputfile = argv[1];
-    const char* outputfile = argv[2];
-
-    cout << "Input file: " << inputfile << endl;
-    cout << "Output file: " << outputfile << endl;
+// Checkpoints of a solution next to it: output.json -> output.checkpoint.json
+string checkpointFile(const string& outputfile) {
+    return std::filesystem::path(outputfile).replace_extension(".checkpoint.json").string();
+}
 
-    cout << "test" << endl;
+//
+// Batch mode: the instances of a directory (every *.json, written under the
+// same name to the output directory) or of a manifest (one "input output"
+// pair per line, # for comments), solved by a pool of workers. The summary
+// of all of them goes to <output directory>/summary.json.
+//
+int runBatch(const char* source, const char* outputdir, int workers, double time_limit, double checkpoint_interval) {
+    vector<SolveReport> reports;
+
+    std::filesystem::create_directories(outputdir);
+
+    if (std::filesystem::is_directory(source)) {
+        vector<std::filesystem::path> inputs;
+
+        for (const auto& entry : std::filesystem::directory_iterator(source)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                inputs.push_back(entry.path());
+            }
+        }
+
+        std::sort(inputs.begin(), inputs.end());
+
+        for (const auto& input : inputs) {
+            SolveReport report;
+            report.input = input.string();
+            report.output = (std::filesystem::path(outputdir) / input.filename()).string();
+            report.time_limit = time_limit;
+            reports.push_back(report);
+        }
+    } else {
+        std::ifstream manifest(source);
 
-    // Load file:
-    JsonLoader loader;
+        if (!manifest) {
+            POLYG_LOG(ERROR, "Cannot read the batch manifest " << source);
+            return -1;
+        }
 
-    loader.load(inputfile);
+        string line;
 
-    JsonExporter exporter(loader.getInstance());
+        while (std::getline(manifest, line)) {
+            std::istringstream fields(line);
+            SolveReport report;
 
-    loader.print();
+            if (!(fields >> report.input) || report.input[0] == '#') {
+                continue;
+            }
 
-    CDT cdt;
+            if (!(fields >> report.output)) {
+                POLYG_LOG(ERROR, "Manifest line without output file: " << line);
+                return -1;
+            }
 
-    //
-    // Add vertices to graph
-    //
-    vector<Point> points = loader.getPoints();
+            report.time_limit = time_limit;
 
-    for (const Point& p : points) {
-        cdt.insert(p);
+            reports.push_back(report);
+        }
     }
 
-    //
-    // Add edges to graph
-    //
-    std::vector<std::pair<int, int>> constraints = loader.getConstraints();
-
-    for (const auto& constraint : constraints) {
-        cdt.insert_constraint(points[constraint.first], points[constraint.second]);
+    if (checkpoint_interval > 0) {
+        for (SolveReport& report : reports) {
+            report.checkpoint = checkpointFile(report.output);
+            report.checkpoint_interval = checkpoint_interval;
+        }
     }
 
-    //
-    // Add boundaries as edges to graph
-    //
-    std::vector<int> boundary_constraints = loader.getRegionBoundaries();
+    POLYG_LOG(INFO, "Batch: " << reports.size() << " instances, " << workers << " workers");
 
-    for (size_t i = 0, j = 1; i < boundary_constraints.size() && j < boundary_constraints.size(); i++, j++) {
-        cdt.insert_constraint(points[boundary_constraints[i]], points[boundary_constraints[j]]);
-    }
+    ThreadPool pool(workers);
 
-    cdt.insert_constraint(points[boundary_constraints[boundary_constraints.size() - 1]], points[boundary_constraints[0]]);
+    pool.run((int)reports.size(), [&reports](int i) {
+        SolveReport& report = reports[i];
+        auto start = std::chrono::steady_clock::now();
 
-    //
-    // Create a polygon for the boundary
-    //
-    Polygon boundaryPolygon;
-
-    for (size_t i = 0; i < boundary_constraints.size(); i++) {
-        boundaryPolygon.push_back(points[boundary_constraints[i]]);
-    }
+        try {
+            if (solve(report.input.c_str(), report.output.c_str(), report, false) != 0) {
+                report.status = "failed";
+            }
+        } catch (const std::exception& e) {
+            POLYG_LOG(ERROR, "Instance " << report.input << ": " << e.what());
+            report.status = "error";
+        }
 
-    // CGAL::draw(cdt);
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
 
     //
-    // Triangulation
+    // Summary
     //
+    boost::property_tree::ptree pt_root;
+    boost::property_tree::ptree pt_instances;
+
+    for (const SolveReport& report : reports) {
+        boost::property_tree::ptree pt_instance;
+
+        pt_instance.put("input", report.input);
+        pt_instance.put("output", report.output);
+        pt_instance.put("method", report.method);
+        pt_instance.put("status", report.status);
+        pt_instance.put("seed", report.seed);
+        pt_instance.put("interrupted", report.interrupted);
+        pt_instance.put("seconds", report.seconds);
+        pt_instance.put("obtuse_initial", report.obtuse_initial);
+        pt_instance.put("obtuse_final", report.obtuse_final);
+        pt_instance.put("steiner_points", report.steiner_points);
+
+        if (report.has_energy) {
+            pt_instance.put("energy", report.energy);
+        }
+
+        pt_instances.push_back(std::make_pair("", pt_instance));
+    }
 
-    Graph graph;
-    graph.cdt = &cdt;
-
-    vector<Point> steinerPoints;
-
-    if (loader.getMethod() == "legacy") {
-        SimpleTriangulationSearch<float> triangulator;
-
-        steiner_stategies::Strategy strategy = steiner_stategies::Strategy::PROJECTION;
-        steinerPoints = triangulator.triangulate(strategy, graph, loader, boundaryPolygon);
-    } else if (loader.getMethod() == "local") {
-        LocalSearch<float> triangulator;
-
-        vector<steiner_stategies::Strategy> strategies;
-
-        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
-        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
-        strategies.push_back(steiner_stategies::Strategy::POLYGON);
-        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
-        strategies.push_back(steiner_stategies::Strategy::BISECTION);
-
-        steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon);
-    } else if (loader.getMethod() == "sa") {
-        SimulatedAnnealingSearch<float> triangulator;
-
-        vector<steiner_stategies::Strategy> strategies;
-
-        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
-        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
-        strategies.push_back(steiner_stategies::Strategy::POLYGON);
-        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
-        // strategies.push_back(steiner_stategies::Strategy::BISECTION);
-
-
-        float alpha = loader.alpha;
-        float beta = loader.beta;
-
-        cout << "Alpha: " << alpha << endl;
-        cout << "Beta: " << beta << endl;
-
-        steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta);
-    } else if (loader.getMethod() == "ant") {
-        AntColonySearch<float> triangulator;
-
-        vector<steiner_stategies::Strategy> strategies;
-
-        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
-        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
-        strategies.push_back(steiner_stategies::Strategy::POLYGON);
-        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
-        // strategies.push_back(steiner_stategies::Strategy::BISECTION);
+    pt_root.put("instances_total", reports.size());
+    pt_root.add_child("instances", pt_instances);
 
+    string summaryfile = (std::filesystem::path(outputdir) / "summary.json").string();
 
-        float alpha = loader.alpha;
-        float beta = loader.beta;
+    POLYG_LOG(INFO, "Saving batch summary ... " << summaryfile);
+    boost::property_tree::write_json(summaryfile, pt_root);
 
-        cout << "Alpha: " << alpha << endl;
-        cout << "Beta: " << beta << endl;
+    return 0;
+}
 
-        steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta);
+// Ctrl-C (or the SIGTERM of a scheduler) stops the searches, which still
+// write their solutions; a second one ends the process
+void stopSearches(int signal) {
+    Deadline::cancelAll();
+    std::signal(signal, SIG_DFL);
+}
 
-    } else {
-        cerr << "Unknown method of search \n";
-        return -1;
+int main(int argc, char* argv[]) {
+    POLYG_LOG(INFO, "Checking CGAL version ... " << CGAL_VERSION_STR);
+
+    std::signal(SIGINT, stopSearches);
+    std::signal(SIGTERM, stopSearches);
+
+    double time_limit = 0;          // anytime mode: seconds for each instance (overrides parameters.time_limit)
+    double checkpoint_interval = 0; // seconds between the checkpoints of sa and ant, none if 0
+    string resume;                  // checkpoint to continue from
+
+    while (argc >= 3 && string(argv[1]).rfind("--", 0) == 0 && string(argv[1]) != "--batch") {
+        string option = argv[1];
+
+        if (option == "--time-limit") {
+            time_limit = atof(argv[2]);
+        } else if (option == "--checkpoint") {
+            checkpoint_interval = atof(argv[2]);
+        } else if (option == "--resume") {
+            resume = argv[2];
+        } else {
+            break;
+        }
+
+        argc -= 2;
+        argv += 2;
     }
 
-    //
-    // Export
-    //
+    if (argc >= 4 && string(argv[1]) == "--batch" && resume.empty()) {
+        int workers = argc > 4 ? atoi(argv[4]) : (int)std::thread::hardware_concurrency();
 
-    for (Point& p : steinerPoints) {
-        string s1 = to_rational(p.x());
-        string s2 = to_rational(p.y());
-        exporter.steiner_points_x.emplace_back(s1);
-        exporter.steiner_points_y.emplace_back(s2);
+        return runBatch(argv[2], argv[3], workers < 1 ? 1 : workers, time_limit, checkpoint_interval);
     }
 
-    std::vector<Vertex_handle> vertices;
+    if (argc != 3 || string(argv[1]) == "--batch") {
+        logging::flush();
 
-    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
-        vertices.push_back(vit); // Store the vertex handle
+        cout << "Invalid arguments: syntax: ./polyg [options] input.json output.json" << endl;
+        cout << "                       or: ./polyg [options] --batch input_directory|manifest output_directory [workers]" << endl;
+        cout << "Options: --time-limit seconds    stop the search after seconds, keeping the best solution" << endl;
+        cout << "         --checkpoint seconds    save sa and ant searches to output.checkpoint.json every seconds" << endl;
+        cout << "         --resume checkpoint     continue a search from its checkpoint (not with --batch)" << endl;
+        return 0;
     }
 
-    for (auto edge = cdt.finite_edges_begin(); edge != cdt.finite_edges_end(); ++edge) {
-        Vertex_handle v1 = edge->first->vertex(cdt.cw(edge->second));
-        Vertex_handle v2 = edge->first->vertex(cdt.ccw(edge->second));
-
-        int x1 = std::find(vertices.begin(), vertices.end(), v1) - vertices.begin(); // Index of vertex 1
-        int x2 = std::find(vertices.begin(), vertices.end(), v2) - vertices.begin(); // Index of vertex 2
+    SolveReport report;
+    report.time_limit = time_limit;
+    report.resume = resume;
 
-        exporter.edges.emplace_back(x1, x2);
+    if (checkpoint_interval > 0) {
+        report.checkpoint = checkpointFile(argv[2]);
+        report.checkpoint_interval = checkpoint_interval;
     }
 
-    // exporter.print();
-
-    // Save JSON
-    cout << "Saving to file ... " << outputfile << endl;
-    exporter.save(outputfile);
-    
-
-    CGAL::draw(cdt);
-
-    return 0;
+    try {
+        return solve(argv[1], argv[2], report, true);
+    } catch (const std::exception& e) {
+        POLYG_LOG(ERROR, e.what());
+        return 1;
+    }
 }